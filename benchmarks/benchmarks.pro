@@ -0,0 +1,13 @@
+#******************************************************************************
+# @file    benchmarks.pro
+# @author  agent
+# @date    14.10.2026
+# @brief   qmake project building all benchmarks
+#
+#******************************************************************************
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    invokemacros \
+    remotedbusconnection
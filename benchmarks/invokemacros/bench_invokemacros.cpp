@@ -0,0 +1,207 @@
+/**
+ * @file    bench_invokemacros.cpp
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Benchmark of QTMETAMETHOD_INVOKE macros and QtExtra::invoke templates against direct calls and QMetaObject::invokeMethod()
+ */
+
+#include <qcoreapplication.h>
+#include <qobject.h>
+#include <QtTest>
+#include "core/invoke.h"
+#include "core/qt.h"
+
+class Receiver : public QObject
+{
+    Q_OBJECT
+public:
+    Receiver() : counter(0) {}
+    int counter;
+public Q_SLOTS:
+    void increment() {counter++;}
+    void add(int value) {counter += value;}
+    int addAndGet(int value) {counter += value; return counter;}
+};
+
+class BenchInvokeMacros : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void directCall();
+    void directCallArgs1();
+    void invokeMethodByName();
+    void invokeMethodByNameArgs1();
+    void invokeMethodByNameRetArgs1();
+    void invokeMacro();
+    void invokeMacroArgs1();
+    void invokeMacroRetArgs1();
+    void invokeTemplate();
+    void invokeTemplateArgs1();
+    void invokeTemplateRetArgs1();
+    void invokeMethodByNameQueued();
+    void invokeMacroQueued();
+    void invokeTemplateQueued();
+    void invokeMemberQueued();
+    void invokeMemberQueuedBurst();
+    void coalescedInvokerBurst();
+    void coalescedMacroBurst();
+
+private:
+    Receiver receiver;
+};
+
+void BenchInvokeMacros::directCall()
+{
+    QBENCHMARK {
+        receiver.increment();
+    }
+}
+
+void BenchInvokeMacros::directCallArgs1()
+{
+    QBENCHMARK {
+        receiver.add(1);
+    }
+}
+
+void BenchInvokeMacros::invokeMethodByName()
+{
+    QBENCHMARK {
+        QMetaObject::invokeMethod(&receiver, "increment", Qt::DirectConnection);
+    }
+}
+
+void BenchInvokeMacros::invokeMethodByNameArgs1()
+{
+    QBENCHMARK {
+        QMetaObject::invokeMethod(&receiver, "add", Qt::DirectConnection, Q_ARG(int, 1));
+    }
+}
+
+void BenchInvokeMacros::invokeMethodByNameRetArgs1()
+{
+    int result = 0;
+    QBENCHMARK {
+        QMetaObject::invokeMethod(&receiver, "addAndGet", Qt::DirectConnection, Q_RETURN_ARG(int, result), Q_ARG(int, 1));
+    }
+    QCOMPARE(result, receiver.counter);
+}
+
+void BenchInvokeMacros::invokeMacro()
+{
+    Receiver *obj = &receiver;
+    QBENCHMARK {
+        QTMETAMETHOD_INVOKE(obj, increment, Qt::DirectConnection);
+    }
+}
+
+void BenchInvokeMacros::invokeMacroArgs1()
+{
+    Receiver *obj = &receiver;
+    QBENCHMARK {
+        QTMETAMETHOD_INVOKE_ARGS1(obj, add, Qt::DirectConnection, (int, 1));
+    }
+}
+
+void BenchInvokeMacros::invokeMacroRetArgs1()
+{
+    Receiver *obj = &receiver;
+    int result = 0;
+    QBENCHMARK {
+        QTMETAMETHOD_INVOKE_RET_ARGS1(obj, addAndGet, Qt::DirectConnection, (int, result), (int, 1));
+    }
+    QCOMPARE(result, receiver.counter);
+}
+
+void BenchInvokeMacros::invokeTemplate()
+{
+    QBENCHMARK {
+        QtExtra::invoke(&receiver, QTMETAMETHOD(Receiver, increment), Qt::DirectConnection);
+    }
+}
+
+void BenchInvokeMacros::invokeTemplateArgs1()
+{
+    QBENCHMARK {
+        QtExtra::invoke(&receiver, QTMETAMETHOD(Receiver, add), Qt::DirectConnection, 1);
+    }
+}
+
+void BenchInvokeMacros::invokeTemplateRetArgs1()
+{
+    int result = 0;
+    QBENCHMARK {
+        QtExtra::invokeRet(&receiver, QTMETAMETHOD(Receiver, addAndGet), Qt::DirectConnection, result, 1);
+    }
+    QCOMPARE(result, receiver.counter);
+}
+
+// Queued variants include posting and delivering event
+
+void BenchInvokeMacros::invokeMethodByNameQueued()
+{
+    QBENCHMARK {
+        QMetaObject::invokeMethod(&receiver, "add", Qt::QueuedConnection, Q_ARG(int, 1));
+        QCoreApplication::sendPostedEvents(&receiver, QEvent::MetaCall);
+    }
+}
+
+void BenchInvokeMacros::invokeMacroQueued()
+{
+    Receiver *obj = &receiver;
+    QBENCHMARK {
+        QTMETAMETHOD_INVOKE_QUEUED_ARGS1(obj, add, (int, 1));
+        QCoreApplication::sendPostedEvents(obj, QEvent::MetaCall);
+    }
+}
+
+void BenchInvokeMacros::invokeTemplateQueued()
+{
+    QBENCHMARK {
+        QtExtra::invokeQueued(&receiver, QTMETAMETHOD(Receiver, add), 1);
+        QCoreApplication::sendPostedEvents(&receiver, QEvent::MetaCall);
+    }
+}
+
+void BenchInvokeMacros::invokeMemberQueued()
+{
+    QBENCHMARK {
+        QtExtra::invokeQueued(&receiver, &Receiver::add, 1);
+        QCoreApplication::sendPostedEvents(); // calls are posted to private receiver
+    }
+}
+
+// Bursts measure 100 posts delivered within single event loop cycle
+
+void BenchInvokeMacros::invokeMemberQueuedBurst()
+{
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+            QtExtra::invokeQueued(&receiver, &Receiver::add, 1);
+        QCoreApplication::sendPostedEvents();
+    }
+}
+
+void BenchInvokeMacros::coalescedInvokerBurst()
+{
+    QtExtra::CoalescedInvoker<Receiver, int> invoker(&receiver, &Receiver::add);
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+            invoker.post(1);
+        QCoreApplication::sendPostedEvents();
+    }
+}
+
+void BenchInvokeMacros::coalescedMacroBurst()
+{
+    Receiver *obj = &receiver;
+    QBENCHMARK {
+        for (int i = 0; i < 100; i++)
+            QTMETAMETHOD_INVOKE_QUEUED_COALESCED(obj, increment);
+        QCoreApplication::sendPostedEvents();
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchInvokeMacros)
+
+#include "bench_invokemacros.moc"
@@ -0,0 +1,18 @@
+#******************************************************************************
+# @file    invokemacros.pro
+# @author  agent
+# @date    14.10.2026
+# @brief   qmake project of QTMETAMETHOD_INVOKE macros and QtExtra::invoke templates benchmark
+#
+#******************************************************************************
+
+QT += testlib
+QT -= gui
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = bench_invokemacros
+INCLUDEPATH += $$PWD/../../src
+
+SOURCES += \
+    bench_invokemacros.cpp
@@ -0,0 +1,205 @@
+/**
+ * @file    bench_remotedbusconnection.cpp
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Benchmark of RemoteDBusConnection against local dbus-daemon listening on TCP
+ */
+
+#include <qcoreapplication.h>
+#include <qdbusmessage.h>
+#include <qdbuspendingcall.h>
+#include <qfile.h>
+#include <qprocess.h>
+#include <qregularexpression.h>
+#include <qtemporarydir.h>
+#include <qthread.h>
+#include <QtTest>
+#include "dbus/remotedbusconnection.h"
+
+using namespace QtExtra;
+
+static const char echo_service[] = "org.qtextra.Benchmark";
+static const char echo_path[] = "/echo";
+static const char echo_interface[] = "org.qtextra.Benchmark";
+static const int open_timeout_ms = 5000;
+
+// Bus accepting anonymous clients over TCP, so it doesn't depend on cookies in user home directory
+static const char dbus_daemon_config[] =
+        "<!DOCTYPE busconfig PUBLIC \"-//freedesktop//DTD D-BUS Bus Configuration 1.0//EN\"\n"
+        " \"http://www.freedesktop.org/standards/dbus/1.0/busconfig.dtd\">\n"
+        "<busconfig>\n"
+        "  <type>session</type>\n"
+        "  <listen>tcp:host=127.0.0.1,bind=127.0.0.1,port=0</listen>\n"
+        "  <auth>ANONYMOUS</auth>\n"
+        "  <allow_anonymous/>\n"
+        "  <policy context=\"default\">\n"
+        "    <allow send_destination=\"*\" eavesdrop=\"true\"/>\n"
+        "    <allow eavesdrop=\"true\"/>\n"
+        "    <allow own=\"*\"/>\n"
+        "  </policy>\n"
+        "</busconfig>\n";
+
+class EchoObject : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.qtextra.Benchmark")
+public Q_SLOTS:
+    QByteArray echo(const QByteArray &data) {return data;}
+};
+
+class BenchRemoteDBusConnection : public QObject
+{
+    Q_OBJECT
+public:
+    BenchRemoteDBusConnection() : daemon_port(0), client(nullptr), server(nullptr), echo_object(nullptr) {}
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void openConnection();
+    void wrappedOperation();
+    void send_data();
+    void send();
+    void roundTrip_data();
+    void roundTrip();
+
+private:
+    static void addMessageSizes();
+    bool waitForOpened(RemoteDBusConnection *connection);
+    static bool waitForClosed(RemoteDBusConnection *connection);
+
+    QTemporaryDir daemon_dir;
+    QProcess daemon;
+    quint16 daemon_port;
+    RemoteDBusConnection *client;
+    RemoteDBusConnection *server;
+    QThread echo_thread;
+    EchoObject *echo_object;
+};
+
+void BenchRemoteDBusConnection::initTestCase()
+{
+    QVERIFY(daemon_dir.isValid());
+    QFile config(daemon_dir.filePath("bus.conf"));
+    QVERIFY(config.open(QIODevice::WriteOnly));
+    config.write(dbus_daemon_config);
+    config.close();
+    daemon.start("dbus-daemon", QStringList() << "--nofork" << "--print-address"
+                                               << ("--config-file=" + config.fileName()));
+    if (!daemon.waitForStarted())
+        QSKIP("dbus-daemon isn't available");
+    QVERIFY(daemon.waitForReadyRead(open_timeout_ms));
+    QString address = QString::fromLatin1(daemon.readLine()).trimmed();
+    QRegularExpressionMatch match = QRegularExpression("port=(\\d+)").match(address);
+    QVERIFY2(match.hasMatch(), qPrintable(address));
+    daemon_port = quint16(match.captured(1).toUInt());
+
+    client = new RemoteDBusConnection("bench_client", this);
+    server = new RemoteDBusConnection("bench_server", this);
+    QVERIFY(waitForOpened(client));
+    QVERIFY(waitForOpened(server));
+
+    // Echo object must live out of main thread, since main thread blocks waiting for replies
+    echo_object = new EchoObject();
+    echo_object->moveToThread(&echo_thread);
+    QObject::connect(&echo_thread, &QThread::finished, echo_object, &QObject::deleteLater);
+    echo_thread.start();
+    QVERIFY(server->registerObject(echo_path, echo_object, QDBusConnection::ExportAllSlots));
+    QVERIFY(server->registerService(echo_service));
+}
+
+void BenchRemoteDBusConnection::cleanupTestCase()
+{
+    if (daemon.state() == QProcess::NotRunning)
+        return;
+    delete client;
+    delete server;
+    echo_thread.quit();
+    echo_thread.wait();
+    daemon.terminate();
+    daemon.waitForFinished();
+}
+
+void BenchRemoteDBusConnection::openConnection()
+{
+    RemoteDBusConnection connection("bench_open");
+    QBENCHMARK {
+        QVERIFY(waitForOpened(&connection));
+        QVERIFY(connection.closeConnection());
+        QVERIFY(waitForClosed(&connection));
+    }
+}
+
+void BenchRemoteDBusConnection::wrappedOperation()
+{
+    // Local lookup, so it measures wrapper overhead only
+    QBENCHMARK {
+        client->objectRegisteredAt(echo_path);
+    }
+}
+
+void BenchRemoteDBusConnection::send_data()
+{
+    addMessageSizes();
+}
+
+void BenchRemoteDBusConnection::send()
+{
+    QFETCH(int, size);
+    QDBusMessage message = QDBusMessage::createSignal(echo_path, echo_interface, "data");
+    message << QByteArray(size, 'x');
+    QBENCHMARK {
+        QVERIFY(client->send(message));
+    }
+    // Let queued data leave before next measurement
+    QDBusMessage ping = QDBusMessage::createMethodCall("org.freedesktop.DBus", "/org/freedesktop/DBus",
+                                                       "org.freedesktop.DBus.Peer", "Ping");
+    QDBusPendingCall call = client->asyncCall(ping, open_timeout_ms * 10);
+    call.waitForFinished();
+    QVERIFY(!call.isError());
+}
+
+void BenchRemoteDBusConnection::roundTrip_data()
+{
+    addMessageSizes();
+}
+
+void BenchRemoteDBusConnection::roundTrip()
+{
+    QFETCH(int, size);
+    QDBusMessage message = QDBusMessage::createMethodCall(echo_service, echo_path, echo_interface, "echo");
+    message << QByteArray(size, 'x');
+    QBENCHMARK {
+        QDBusPendingCall call = client->asyncCall(message, open_timeout_ms);
+        call.waitForFinished();
+        QVERIFY(!call.isError());
+    }
+}
+
+void BenchRemoteDBusConnection::addMessageSizes()
+{
+    QTest::addColumn<int>("size");
+    for (int size = 64; size <= (1 << 20); size *= 16)
+        QTest::newRow(qPrintable(QString("%1 B").arg(size))) << size;
+    QTest::newRow("1048576 B") << (1 << 20);
+}
+
+bool BenchRemoteDBusConnection::waitForOpened(RemoteDBusConnection *connection)
+{
+    QSignalSpy spy(connection, &RemoteDBusConnection::connectionOpened);
+    if (!connection->openConnection("127.0.0.1", daemon_port))
+        return false;
+    if (!spy.wait(open_timeout_ms))
+        return false;
+    return spy.first().first().toBool();
+}
+
+bool BenchRemoteDBusConnection::waitForClosed(RemoteDBusConnection *connection)
+{
+    QSignalSpy spy(connection, &RemoteDBusConnection::connectionClosed);
+    return spy.wait(open_timeout_ms);
+}
+
+QTEST_GUILESS_MAIN(BenchRemoteDBusConnection)
+
+#include "bench_remotedbusconnection.moc"
@@ -0,0 +1,20 @@
+#******************************************************************************
+# @file    remotedbusconnection.pro
+# @author  agent
+# @date    14.10.2026
+# @brief   qmake project of RemoteDBusConnection benchmark
+#
+#******************************************************************************
+
+QT += testlib dbus network
+QT -= gui
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = bench_remotedbusconnection
+INCLUDEPATH += $$PWD/../../src
+
+include($$PWD/../../src/dbus.pri)
+
+SOURCES += \
+    bench_remotedbusconnection.cpp
@@ -0,0 +1,224 @@
+/**
+ * @file    invoke.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Variadic template alternative to QTMETAMETHOD_INVOKE macros
+ */
+
+#ifndef QTEXTRA_INVOKE_H
+#define QTEXTRA_INVOKE_H
+
+#include "invoke_p.h"
+#include <qcoreapplication.h>
+#include <memory>
+#include <utility>
+
+/**
+ * \defgroup QTEXTRA_INVOKE QtExtra::invoke templates
+ *
+ * Set of function templates doing same as QTMETAMETHOD_INVOKE_* macros (see qt.h),
+ * but without macro expansion per arguments count:
+ * - argument types are deduced from method pointer and checked at compile time
+ *   (passed values must be implicitly convertible to them);
+ * - method is resolved in meta-object once per method (not per call site) and then invoked via QMetaMethod::invoke().
+ *
+ * Method is referenced with QTMETAMETHOD(Class, member) macro or,
+ * if it's overloaded, with QTMETAMETHOD_OVERLOAD(Class, member, ret, args) macro, explicitly selecting signature.
+ * Overloads having same arguments count are told apart at run time by arguments metatypes,
+ * so their types must be declared as metatypes (see Q_DECLARE_METATYPE()).
+ * If several overloads still match, method isn't resolved and invocation fails.
+ *
+ * Invoked method may have at most 10 arguments (QMetaMethod::invoke() limitation).
+ *
+ * For queued calls there are also postQueued() and invokeQueued() overload taking plain member pointer.
+ * They don't use meta-object system at all: functor (or member pointer with arguments moved to std::tuple)
+ * is moved into single posted event, so arguments are neither copied via metatypes nor need to be registered
+ * with qRegisterMetaType(), and any method (not only invokable) may be called.
+ * CoalescedInvoker does same, but merges repeated calls while previous one is still pending
+ * (QTMETAMETHOD_INVOKE_QUEUED_COALESCED() macro from qt.h does it for invokable methods without arguments).
+ *
+ * Example usage:
+ * \code{.cpp}
+ * QWidget *widget;
+ * bool result;
+ * QtExtra::invokeRet(widget, QTMETAMETHOD(QWidget, close), Qt::BlockingQueuedConnection, result); // waits for result
+ * QAbstractSocket *socket;
+ * QNetworkProxy proxy;
+ * QAuthenticator authenticator;
+ * QtExtra::invoke(socket, QTMETAMETHOD(QAbstractSocket, proxyAuthenticationRequired), Qt::BlockingQueuedConnection,
+ *                 proxy, &authenticator);
+ * QTimer *timer;
+ * QtExtra::invokeQueued(timer, QTMETAMETHOD_OVERLOAD(QTimer, start, void, (int)), 100);
+ * MyProcessor *processor; // user class with method "void process(QByteArray data)"
+ * QByteArray data;
+ * QtExtra::invokeQueued(processor, &MyProcessor::process, std::move(data)); // no copies, no metatypes
+ * QtExtra::postQueued(socket, [=]() { socket->setReadBufferSize(1024); });
+ * \endcode
+ */
+/**@{*/
+
+//! Reference to invokable method of class
+#define QTMETAMETHOD(Class, member) \
+    QtExtra::InvokableMethod<decltype(&Class::member), &Class::member>(#member)
+
+//! Reference to overloaded invokable method of class with signature "ret args" (args must be in parentheses)
+#define QTMETAMETHOD_OVERLOAD(Class, member, ret, args) \
+    QtExtra::InvokableMethod<ret (Class::*)args, &Class::member>(#member)
+
+namespace QtExtra {
+
+//! Invokable method reference (use QTMETAMETHOD() macros to construct it)
+template <class Method, Method method>
+class InvokableMethod
+{
+public:
+    typedef QtExtraPrivate::InvokeMethodTraits<Method> Traits;
+
+    explicit InvokableMethod(const char *name) : name(name) {}
+
+    const QtExtraPrivate::InvokeMetaMethod &metaMethod() const
+    {
+        static const QtExtraPrivate::InvokeMetaMethod meta_method =
+                Traits::Arguments::resolve(Traits::ClassType::staticMetaObject, name);
+        return meta_method;
+    }
+
+private:
+    const char *name;
+};
+
+//! Invokes method without return value.
+/*!
+  Equivalent to QMetaObject::invokeMethod(obj, "member", type, ...).
+*/
+template <class T, class Method, Method method, class... Values>
+inline bool invoke(T *obj, const InvokableMethod<Method, method> &member, Qt::ConnectionType type, Values &&... values)
+{
+    typedef typename InvokableMethod<Method, method>::Traits Traits;
+    static_assert(std::is_base_of<typename Traits::ClassType, T>::value, "Method doesn't belong to object class");
+    return Traits::Arguments::invoke(member.metaMethod(), obj, type, QGenericReturnArgument(),
+                                     std::forward<Values>(values)...);
+}
+
+//! Invokes method storing its return value in ret.
+/*!
+  Equivalent to QMetaObject::invokeMethod(obj, "member", type, Q_RETURN_ARG(..., ret), ...).
+  Return value can't be received with Qt::QueuedConnection (invocation fails).
+*/
+template <class T, class Method, Method method, class... Values>
+inline bool invokeRet(T *obj, const InvokableMethod<Method, method> &member, Qt::ConnectionType type,
+                      typename InvokableMethod<Method, method>::Traits::ReturnType &ret, Values &&... values)
+{
+    typedef typename InvokableMethod<Method, method>::Traits Traits;
+    static_assert(std::is_base_of<typename Traits::ClassType, T>::value, "Method doesn't belong to object class");
+    const QtExtraPrivate::InvokeMetaMethod &meta_method = member.metaMethod();
+    return Traits::Arguments::invoke(meta_method, obj, type,
+                                     QGenericReturnArgument(meta_method.return_type_name.constData(), &ret),
+                                     std::forward<Values>(values)...);
+}
+
+//! Invokes method asynchronously and without return value.
+/*!
+  Equivalent to QMetaObject::invokeMethod(obj, "member", Qt::QueuedConnection, ...).
+*/
+template <class T, class Method, Method method, class... Values>
+inline bool invokeQueued(T *obj, const InvokableMethod<Method, method> &member, Values &&... values)
+{
+    return invoke(obj, member, Qt::QueuedConnection, std::forward<Values>(values)...);
+}
+
+//! Calls functor asynchronously in obj thread.
+/*!
+  Functor is moved into single event posted to private receiver living in obj thread,
+  and called when event is delivered (in order with other events posted to that thread).
+  If obj is destroyed before that (or event is discarded), functor isn't called (it's only destroyed).
+  \note
+  Since event isn't posted to obj itself, QCoreApplication::sendPostedEvents() and QCoreApplication::removePostedEvents()
+  affect it only if called without receiver. Calls pending when obj thread finishes are discarded.
+*/
+template <class T, class Functor>
+inline void postQueued(T *obj, Functor &&functor)
+{
+    typedef QtExtraPrivate::QueuedCallEvent<typename std::decay<Functor>::type> Event;
+    QTEXTRA_TRACE1(post_queued, static_cast<const void *>(obj));
+    typename std::decay<Functor>::type moved_functor(std::forward<Functor>(functor));
+    QtExtraPrivate::QueuedCallDispatcher::post(obj, new Event(obj, std::move(moved_functor)));
+}
+
+//! Invokes obj method asynchronously, moving arguments instead of copying them via metatypes.
+/*!
+  Method may be any member of obj class (it isn't looked up in meta-object).
+  Arguments are checked against method signature at compile time, converted to its parameter types
+  in caller thread (so no pointers to caller data are queued instead of values) and delivered same as with postQueued().
+*/
+template <class T, class R, class C, class... Args, class... Values>
+inline void invokeQueued(T *obj, R (C::*method)(Args...), Values &&... values)
+{
+    static_assert(std::is_base_of<C, T>::value, "Method doesn't belong to object class");
+    static_assert(sizeof...(Args) == sizeof...(Values), "Arguments count doesn't match method signature");
+    typedef QtExtraPrivate::QueuedMemberCall<C, R (C::*)(Args...), typename std::decay<Args>::type...> Call;
+    postQueued(obj, Call(obj, method, std::forward<Values>(values)...));
+}
+
+//! Invokes obj const method asynchronously, moving arguments instead of copying them via metatypes.
+/*!
+  Same as invokeQueued() overload for non-const method.
+*/
+template <class T, class R, class C, class... Args, class... Values>
+inline void invokeQueued(T *obj, R (C::*method)(Args...) const, Values &&... values)
+{
+    static_assert(std::is_base_of<C, T>::value, "Method doesn't belong to object class");
+    static_assert(sizeof...(Args) == sizeof...(Values), "Arguments count doesn't match method signature");
+    typedef QtExtraPrivate::QueuedMemberCall<C, R (C::*)(Args...) const, typename std::decay<Args>::type...> Call;
+    postQueued(obj, Call(obj, method, std::forward<Values>(values)...));
+}
+
+//! Queued invoker merging repeated calls of object method while previous one is pending.
+/*!
+  At most one invocation per invoker instance is queued: post() called while call is still pending
+  only replaces its arguments, so method is called once with the latest ones.
+  post() may be called from any thread. Call merged into pending one takes single atomic exchange,
+  only call finding none pending posts event (as postQueued() does, locking event queue of object thread).
+  Method may be any member of object class, arguments are moved same as with invokeQueued().
+
+  Typical usage is one invoker per (object, method) owned by producer or object itself:
+  \code{.cpp}
+  QtExtra::CoalescedInvoker<MyView> refresh_invoker(view, &MyView::refresh);
+  ...
+  refresh_invoker.post(); // during burst of updates, view is refreshed once per event loop cycle
+  \endcode
+
+  \note
+  Pending call is delivered even if invoker itself is destroyed before that (unless object destroyed).
+  Calls are merged per invoker instance only, so producers sharing (object, method) should share invoker too.
+  For invokable methods without arguments, QTMETAMETHOD_INVOKE_QUEUED_COALESCED() merges calls by (object, method).
+*/
+template <class T, class... Args>
+class CoalescedInvoker
+{
+public:
+    typedef void (T::*Method)(Args...);
+
+    CoalescedInvoker(T *obj, Method method) :
+        state(std::make_shared<QtExtraPrivate::CoalescedCallState<T, Args...> >(obj, method)) {}
+
+    //! Queues call with given arguments, or replaces arguments of already pending one.
+    template <class... Values>
+    void post(Values &&... values)
+    {
+        static_assert(sizeof...(Args) == sizeof...(Values), "Arguments count doesn't match method signature");
+        if (!state->store(std::forward<Values>(values)...))
+            return;
+        std::shared_ptr<QtExtraPrivate::CoalescedCallState<T, Args...> > call_state = state;
+        postQueued(state->obj, [call_state]() {call_state->call();});
+    }
+
+private:
+    std::shared_ptr<QtExtraPrivate::CoalescedCallState<T, Args...> > state;
+};
+
+} // namespace QtExtra
+
+/**@}*/ // end of QTEXTRA_INVOKE
+
+#endif // QTEXTRA_INVOKE_H
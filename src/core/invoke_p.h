@@ -0,0 +1,483 @@
+/**
+ * @file    invoke_p.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Private definitions for QtExtra::invoke() templates
+ */
+
+#ifndef QTEXTRA_INVOKE_P_H
+#define QTEXTRA_INVOKE_P_H
+
+#include <qglobal.h>
+#if (QT_VERSION < QT_VERSION_CHECK(5, 7, 0))
+# error "Qt version 5.7 or later required"
+#endif
+
+#include <qatomic.h>
+#include <qbytearray.h>
+#include <qcoreapplication.h>
+#include <qcoreevent.h>
+#include <qhash.h>
+#include <qlist.h>
+#include <qmetaobject.h>
+#include <qmetatype.h>
+#include <qmutex.h>
+#include <qpair.h>
+#include <qpointer.h>
+#include <qthread.h>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "trace.h"
+
+namespace QtExtraPrivate {
+
+// QMetaMethod::invoke() accepts at most this number of arguments
+static const int invoke_max_arguments_count = 10;
+
+// Metatype id of argument type, or QMetaType::UnknownType if it wasn't declared as metatype
+template <class T>
+inline int invokeArgumentTypeId(std::true_type) {return qMetaTypeId<T>();}
+template <class T>
+inline int invokeArgumentTypeId(std::false_type) {return QMetaType::UnknownType;}
+template <class T>
+inline int invokeArgumentTypeId()
+{
+    typedef typename std::decay<T>::type Type;
+    return invokeArgumentTypeId<Type>(std::integral_constant<bool, QMetaTypeId2<Type>::Defined>());
+}
+
+// Method resolved once and parameters type names kept for building QGenericArgument's
+struct InvokeMetaMethod
+{
+    QMetaMethod method;
+    QByteArray name; // kept for tracing probe, which must not allocate
+    QByteArray return_type_name;
+    QList<QByteArray> parameter_type_names;
+
+    InvokeMetaMethod(const QMetaObject &meta_object, const char *name, const int *argument_type_ids, int arguments_count)
+    {
+        // Methods match by name and arguments count, overloads are told apart by arguments metatypes (if known).
+        // Unknown metatype matches any parameter, so several matching candidates leave method unresolved
+        // (picking one could pass argument as value of another type).
+        int matches_count = 0;
+        for (int index = 0; index < meta_object.methodCount(); index++) {
+            QMetaMethod candidate = meta_object.method(index);
+            if ((candidate.parameterCount() != arguments_count) || (candidate.name() != name))
+                continue;
+            bool matches = true;
+            for (int i = 0; matches && (i < arguments_count); i++)
+                matches = (argument_type_ids[i] == QMetaType::UnknownType) ||
+                          (candidate.parameterType(i) == argument_type_ids[i]);
+            if (matches) {
+                method = candidate;
+                matches_count++;
+            }
+        }
+        if (matches_count > 1) {
+            qWarning("QtExtra::invoke: ambiguous overloads of method %s::%s, declare argument types as metatypes",
+                     meta_object.className(), name);
+            method = QMetaMethod();
+        }
+        Q_ASSERT_X(method.isValid(), "QtExtra::invoke", name);
+        this->name = name;
+        return_type_name = method.typeName();
+        parameter_type_names = method.parameterTypes();
+    }
+
+    QGenericArgument argument(int index, const void *value) const
+    {
+        return QGenericArgument(parameter_type_names.at(index).constData(), value);
+    }
+};
+
+template <class... Args>
+struct InvokeArguments
+{
+    static_assert(sizeof...(Args) <= invoke_max_arguments_count, "Too many arguments for QMetaMethod::invoke()");
+
+    static InvokeMetaMethod resolve(const QMetaObject &meta_object, const char *name)
+    {
+        // Trailing element avoids zero-size array
+        const int argument_type_ids[] = {invokeArgumentTypeId<Args>()..., QMetaType::UnknownType};
+        return InvokeMetaMethod(meta_object, name, argument_type_ids, int(sizeof...(Args)));
+    }
+
+    static bool invoke(const InvokeMetaMethod &meta_method, QObject *obj, Qt::ConnectionType type,
+                       QGenericReturnArgument ret, const typename std::decay<Args>::type &... args)
+    {
+        QTEXTRA_TRACE2(invoke, static_cast<const void *>(obj), meta_method.name.constData());
+        QGenericArgument argv[invoke_max_arguments_count];
+        fill(meta_method, argv, 0, &args...);
+        return meta_method.method.invoke(obj, type, ret,
+                                         argv[0], argv[1], argv[2], argv[3], argv[4],
+                                         argv[5], argv[6], argv[7], argv[8], argv[9]);
+    }
+
+private:
+    static void fill(const InvokeMetaMethod &, QGenericArgument *, int) {}
+    template <class... Values>
+    static void fill(const InvokeMetaMethod &meta_method, QGenericArgument *argv, int index,
+                     const void *value, Values... values)
+    {
+        argv[index] = meta_method.argument(index, value);
+        fill(meta_method, argv, index + 1, values...);
+    }
+};
+
+template <class Method>
+struct InvokeMethodTraits;
+
+template <class R, class C, class... Args>
+struct InvokeMethodTraits<R (C::*)(Args...)>
+{
+    typedef R ReturnType;
+    typedef C ClassType;
+    typedef InvokeArguments<Args...> Arguments;
+};
+
+template <class R, class C, class... Args>
+struct InvokeMethodTraits<R (C::*)(Args...) const> : InvokeMethodTraits<R (C::*)(Args...)> {};
+
+template <int... I>
+struct InvokeIndexSequence {};
+template <int N, int... I>
+struct InvokeMakeIndexSequence : InvokeMakeIndexSequence<N - 1, N - 1, I...> {};
+template <int... I>
+struct InvokeMakeIndexSequence<0, I...> {typedef InvokeIndexSequence<I...> Type;};
+
+inline QEvent::Type queuedCallEventType()
+{
+    static const QEvent::Type type = QEvent::Type(QEvent::registerEventType());
+    return type;
+}
+
+/*
+ * Event is posted to dispatcher living in receiver thread (receiver itself doesn't handle this event type),
+ * so call is ordered with other events posted to that thread, and discarded event is only destroyed.
+ * Receiver destroyed before delivery is recognized by cleared guard, while receiver moved to another thread
+ * gets call re-posted to dispatcher of that thread.
+ */
+class QueuedCallEventBase : public QEvent
+{
+public:
+    explicit QueuedCallEventBase(QObject *receiver) : QEvent(queuedCallEventType()), receiver(receiver) {}
+
+    virtual void call() = 0;
+    // New event taking over functor (delivered event is deleted by event loop)
+    virtual QueuedCallEventBase *take() = 0;
+
+    QPointer<QObject> receiver;
+};
+
+template <class Functor>
+class QueuedCallEvent : public QueuedCallEventBase
+{
+public:
+    QueuedCallEvent(QObject *receiver, Functor &&functor) :
+        QueuedCallEventBase(receiver), functor(std::move(functor)) {}
+
+    void call() override {functor();}
+    QueuedCallEventBase *take() override {return new QueuedCallEvent(receiver.data(), std::move(functor));}
+
+private:
+    Functor functor;
+};
+
+// Receiver of queued call events, one per thread (created at first post and deleted when thread finishes or exits)
+class QueuedCallDispatcher : public QObject
+{
+public:
+    static void post(QObject *receiver, QueuedCallEventBase *event)
+    {
+        QCoreApplication::postEvent(instance(receiver->thread()), event);
+    }
+
+protected:
+    bool event(QEvent *event) override
+    {
+        if (event->type() != queuedCallEventType())
+            return QObject::event(event);
+        QueuedCallEventBase *call_event = static_cast<QueuedCallEventBase *>(event);
+        QObject *receiver = call_event->receiver.data();
+        if (receiver == nullptr)
+            return true;
+        if (receiver->thread() != thread())
+            post(receiver, call_event->take());
+        else
+            call_event->call();
+        return true;
+    }
+
+private:
+    struct Registry
+    {
+        QMutex mutex;
+        QHash<QThread *, QueuedCallDispatcher *> dispatchers;
+        QAtomicInt generation; // changed by every deletion, so cached pointers are known to be valid
+    };
+
+    // Never destroyed, since threads may exit during static objects destruction
+    static Registry *registry()
+    {
+        static Registry *instance = new Registry();
+        return instance;
+    }
+
+    // Dispatcher is cached per posting thread, so registry is locked only when posting to another thread
+    static QueuedCallDispatcher *instance(QThread *thread)
+    {
+        struct CachedDispatcher
+        {
+            QThread *thread;
+            QueuedCallDispatcher *dispatcher;
+            int generation;
+        };
+        static thread_local CachedDispatcher cached = {nullptr, nullptr, 0};
+        Registry *dispatchers_registry = registry();
+        int generation = dispatchers_registry->generation.loadAcquire();
+        if ((cached.dispatcher != nullptr) && (cached.thread == thread) && (cached.generation == generation))
+            return cached.dispatcher;
+        QMutexLocker locker(&dispatchers_registry->mutex);
+        QueuedCallDispatcher *&dispatcher = dispatchers_registry->dispatchers[thread];
+        if (dispatcher == nullptr) {
+            dispatcher = new QueuedCallDispatcher();
+            Q_CHECK_PTR(dispatcher);
+            dispatcher->moveToThread(thread);
+            // Finished thread emits it in its own thread, so dispatcher is deleted there (discarding pending calls).
+            // Adopted threads (main one included) don't finish, their objects are destroyed when they exit instead.
+            QObject::connect(thread, &QThread::finished, dispatcher, [thread]() {
+                release(thread);
+            }, Qt::DirectConnection);
+            QObject::connect(thread, &QObject::destroyed, dispatcher, [thread]() {
+                release(thread);
+            }, Qt::DirectConnection);
+        }
+        cached.thread = thread;
+        cached.dispatcher = dispatcher;
+        cached.generation = generation;
+        return dispatcher;
+    }
+
+    static void release(QThread *thread)
+    {
+        Registry *dispatchers_registry = registry();
+        QMutexLocker locker(&dispatchers_registry->mutex);
+        QueuedCallDispatcher *dispatcher = dispatchers_registry->dispatchers.take(thread);
+        if (dispatcher == nullptr)
+            return;
+        dispatchers_registry->generation.fetchAndAddOrdered(1);
+        delete dispatcher;
+    }
+};
+
+// Member call with arguments moved into it (C++11 lambdas can't capture by move)
+template <class C, class Method, class... Values>
+class QueuedMemberCall
+{
+public:
+    // Values are taken by value, so passed ones are converted to parameter types in caller thread
+    QueuedMemberCall(C *obj, Method method, Values... values) :
+        obj(obj), method(method), values(std::move(values)...) {}
+    void operator()() {call(typename InvokeMakeIndexSequence<sizeof...(Values)>::Type());}
+
+private:
+    template <int... I>
+    void call(InvokeIndexSequence<I...>) {(obj->*method)(std::move(std::get<I>(values))...);}
+
+    C *obj;
+    Method method;
+    std::tuple<Values...> values;
+};
+
+/*
+ * Latest arguments are kept on heap and atomically swapped, so non-null pointer also means that call is pending:
+ * only producer replacing null posts event, and consumer takes arguments by replacing them with null.
+ * Calls without arguments use sentinel (address of static tag, never dereferenced) instead of allocating empty tuple.
+ */
+template <class T, class... Args>
+class CoalescedCallState
+{
+public:
+    typedef void (T::*Method)(Args...);
+    typedef std::tuple<typename std::decay<Args>::type...> Arguments;
+
+    CoalescedCallState(T *obj, Method method) : obj(obj), method(method) {}
+    ~CoalescedCallState() {release(pending_arguments.load());}
+
+    // Returns true if previous call wasn't pending (i.e. new event must be posted)
+    template <class... Values>
+    bool store(Values &&... values)
+    {
+        Arguments *previous = pending_arguments.fetchAndStoreOrdered(allocate(std::forward<Values>(values)...));
+        release(previous);
+        return (previous == nullptr);
+    }
+
+    void call()
+    {
+        std::unique_ptr<Arguments, void (*)(Arguments *)> arguments(pending_arguments.fetchAndStoreOrdered(nullptr),
+                                                                    &CoalescedCallState::release);
+        if (arguments)
+            call(arguments.get(), std::integral_constant<bool, sizeof...(Args) == 0>());
+    }
+
+    T *const obj;
+
+private:
+    // Sentinel isn't dereferenced
+    void call(Arguments *, std::true_type) {(obj->*method)();}
+    void call(Arguments *arguments, std::false_type)
+    {
+        call(*arguments, typename InvokeMakeIndexSequence<sizeof...(Args)>::Type());
+    }
+    template <int... I>
+    void call(Arguments &arguments, InvokeIndexSequence<I...>) {(obj->*method)(std::move(std::get<I>(arguments))...);}
+
+    static Arguments *sentinel()
+    {
+        static char tag;
+        return reinterpret_cast<Arguments *>(&tag);
+    }
+    static Arguments *allocate() {return sentinel();}
+    template <class Value, class... Values>
+    static Arguments *allocate(Value &&value, Values &&... values)
+    {
+        return new Arguments(std::forward<Value>(value), std::forward<Values>(values)...);
+    }
+    static void release(Arguments *arguments) {release(arguments, std::integral_constant<bool, sizeof...(Args) == 0>());}
+    static void release(Arguments *arguments, std::true_type)
+    {
+        if (arguments != sentinel())
+            delete arguments;
+    }
+    static void release(Arguments *arguments, std::false_type) {delete arguments;}
+
+    Method method;
+    QAtomicPointer<Arguments> pending_arguments;
+};
+
+/*
+ * Objects having QTMETAMETHOD_INVOKE_QUEUED_COALESCED() call of one method pending, shared by all macro expansions
+ * naming that method. Pending object occupies slot until its call is delivered or discarded (or object destroyed),
+ * so post finding it there (i.e. merged into pending call) takes only atomic loads.
+ * Slots are claimed under mutex, so object never occupies two of them, while released ones are just cleared.
+ */
+class CoalescedCallSet
+{
+public:
+    static const int slots_count = 64;
+
+    // Never destroyed, same as dispatchers registry
+    static CoalescedCallSet &instance(const QMetaMethod &method)
+    {
+        static Registry *registry = new Registry();
+        QMutexLocker locker(&registry->mutex);
+        CoalescedCallSet *&set = registry->sets[qMakePair(method.enclosingMetaObject(), method.methodIndex())];
+        if (set == nullptr) {
+            set = new CoalescedCallSet();
+            Q_CHECK_PTR(set);
+        }
+        return *set;
+    }
+
+    // Returns slot claimed for obj, or null if its call is already pending (pending = true) or no slot is free
+    QAtomicPointer<QObject> *acquire(QObject *obj, bool &pending)
+    {
+        pending = (find(obj) != nullptr);
+        if (pending)
+            return nullptr;
+        QMutexLocker locker(&mutex);
+        pending = (find(obj) != nullptr);
+        if (pending)
+            return nullptr;
+        for (int i = 0; i < slots_count; i++) {
+            QAtomicPointer<QObject> &slot = slots[(home(obj) + i) % slots_count];
+            if (slot.testAndSetOrdered(nullptr, obj))
+                return &slot;
+        }
+        return nullptr;
+    }
+
+private:
+    struct Registry
+    {
+        QMutex mutex;
+        QHash<QPair<const QMetaObject *, int>, CoalescedCallSet *> sets;
+    };
+
+    static int home(QObject *obj) {return int((quintptr(obj) / sizeof(void *)) % slots_count);}
+
+    // Released slots leave holes in probe sequence, so it's scanned entirely
+    QAtomicPointer<QObject> *find(QObject *obj)
+    {
+        for (int i = 0; i < slots_count; i++) {
+            QAtomicPointer<QObject> &slot = slots[(home(obj) + i) % slots_count];
+            if (slot.loadAcquire() == obj)
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    QMutex mutex;
+    QAtomicPointer<QObject> slots[slots_count];
+};
+
+/*
+ * Call posted by QTMETAMETHOD_INVOKE_QUEUED_COALESCED(), releasing slot right before invoking method
+ * (so post made during call queues next one) or when discarded without call.
+ * Destroyed object releases slot itself (before its address may be reused) and drops connection,
+ * so failed disconnect means that slot must not be touched anymore.
+ */
+class CoalescedMetaCall
+{
+public:
+    CoalescedMetaCall(QObject *obj, const QMetaMethod &method, QAtomicPointer<QObject> *slot) :
+        obj(obj), method(method), slot(slot)
+    {
+        if (slot != nullptr)
+            connection = QObject::connect(obj, &QObject::destroyed, [obj, slot]() {
+                slot->testAndSetOrdered(obj, nullptr);
+            });
+    }
+    CoalescedMetaCall(CoalescedMetaCall &&other) :
+        obj(other.obj), method(other.method), slot(other.slot), connection(std::move(other.connection))
+    {
+        other.slot = nullptr;
+    }
+    ~CoalescedMetaCall() {release();}
+
+    void operator()()
+    {
+        release();
+        method.invoke(obj, Qt::DirectConnection);
+    }
+
+private:
+    void release()
+    {
+        if ((slot != nullptr) && QObject::disconnect(connection))
+            slot->testAndSetOrdered(obj, nullptr);
+        slot = nullptr;
+    }
+
+    QObject *obj;
+    QMetaMethod method;
+    QAtomicPointer<QObject> *slot;
+    QMetaObject::Connection connection;
+};
+
+inline void postCoalesced(QObject *obj, const QMetaMethod &method, CoalescedCallSet &pending_calls)
+{
+    bool pending;
+    QAtomicPointer<QObject> *slot = pending_calls.acquire(obj, pending);
+    if (pending)
+        return;
+    // Without free slot call is posted anyway, just isn't merged with next ones
+    QueuedCallDispatcher::post(obj, new QueuedCallEvent<CoalescedMetaCall>(obj, CoalescedMetaCall(obj, method, slot)));
+}
+
+} // namespace QtExtraPrivate
+
+#endif // QTEXTRA_INVOKE_P_H
@@ -9,6 +9,7 @@
 #define QTEXTRA_QT_H
 
 #include "qt_p.h"
+#include "invoke_p.h"
 #include <qmetaobject.h>
 
 /**
@@ -18,7 +19,13 @@
  * (i.e. signals, slots or suffixed with Q_INVOKABLE).
  * These macros are wrappers around QMetaObject::invokeMethod() with following improvements:
  * - full compile-time check;
- * - slightly reduced reduced invokation code length (omitting Q_ARGs).
+ * - slightly reduced reduced invokation code length (omitting Q_ARGs);
+ * - method is looked up only once per macro expansion: resolved QMetaMethod is cached in function-local static,
+ *   so subsequent calls go directly to QMetaMethod::invoke() without signature normalizing and searching.
+ *
+ * Method is resolved in meta-object of static "obj" type (the one compile-time check is done against).
+ * If its subclass redeclares invokable method with same signature (not overriding virtual one),
+ * then base class method is invoked, unlike QMetaObject::invokeMethod().
  *
  * Unfortunalely, preprocessor doesn't support C++ overload semantics and it wasn't possible
  * to make use of variadic arguments feature.
@@ -37,6 +44,8 @@
  *  - same as QTMETAMETHOD_INVOKE_ARGS<count>, but without without arguments
  * QTMETAMETHOD_INVOKE_QUEUED[_ARGS<count>](obj, member, ...)
  *  - variants for queued-type connection (most popular use case)
+ * QTMETAMETHOD_INVOKE_QUEUED_COALESCED(obj, member)
+ *  - same as QTMETAMETHOD_INVOKE_QUEUED, but merged into call of same (obj, member) if it's still pending
  *
  * These macros doesn't require form user explicit specialization for invoking overloaded variants calls.
  * It's automatically deduced from argument types user provided.
@@ -104,6 +113,30 @@
 //@}
 
 
+//@{
+/** Macro wrapper for invoking QObject method asynchronously, keeping at most one pending call per (obj, member).
+ * Invocation made while call of same method of same object is still pending (posted by any expansion
+ * of this macro in any thread) is dropped, so method is called once per burst of invocations.
+ * Checking for pending call takes only atomic loads, only invocation posting new call locks.
+ * Pending call is released right before method is called, so invocations made from it queue next call.
+ *
+ * Methods with arguments aren't supported, since pending call has no place to keep latest ones
+ * (use QtExtra::CoalescedInvoker from invoke.h instead).
+ * Call is posted same way as QtExtra::postQueued() does, i.e. not to obj itself (see notes there).
+ * While more than 64 objects have call of same method pending, calls of others are posted without merging.
+ */
+
+#define QTMETAMETHOD_INVOKE_QUEUED_COALESCED(obj, member) do { \
+    (void)QOverload<>::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, );\
+    static QtExtraPrivate::CoalescedCallSet &qtextra_pending_calls = QtExtraPrivate::CoalescedCallSet::instance(qtextra_method);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    QtExtraPrivate::postCoalesced(obj, qtextra_method, qtextra_pending_calls);\
+} while(0)
+
+//@}
+
+
 //@{
 /** Macro wrappers for invoking QObject methods without return value.
  * Equivalent to code
@@ -114,14 +147,18 @@
 
 #define QTMETAMETHOD_INVOKE(obj, member, type) do { \
     (void)QOverload<>::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type);\
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, );\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type);\
 } while(0)
 
 #define QTMETAMETHOD_INVOKE_ARGS1(obj, member, type, val0) do { \
     (void)QOverload < \
                     QTEXTRA_ARG(t) val0 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0 \
         );\
 } while(0)
@@ -131,7 +168,9 @@
                     QTEXTRA_ARG(t) val0, \
                     QTEXTRA_ARG(t) val1 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1 \
         );\
@@ -143,7 +182,9 @@
                     QTEXTRA_ARG(t) val1, \
                     QTEXTRA_ARG(t) val2 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2 \
@@ -157,7 +198,9 @@
                     QTEXTRA_ARG(t) val2, \
                     QTEXTRA_ARG(t) val3 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -173,7 +216,9 @@
                     QTEXTRA_ARG(t) val3, \
                     QTEXTRA_ARG(t) val4 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -191,7 +236,9 @@
                     QTEXTRA_ARG(t) val4, \
                     QTEXTRA_ARG(t) val5 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -211,7 +258,9 @@
                     QTEXTRA_ARG(t) val5, \
                     QTEXTRA_ARG(t) val6 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -233,7 +282,9 @@
                     QTEXTRA_ARG(t) val6, \
                     QTEXTRA_ARG(t) val7 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -257,7 +308,9 @@
                     QTEXTRA_ARG(t) val7, \
                     QTEXTRA_ARG(t) val8 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7, QTEXTRA_ARG(t) val8);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -283,7 +336,9 @@
                     QTEXTRA_ARG(t) val8, \
                     QTEXTRA_ARG(t) val9 \
                     >::of(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7, QTEXTRA_ARG(t) val8, QTEXTRA_ARG(t) val9);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -308,15 +363,19 @@
  */
 
 #define QTMETAMETHOD_INVOKE_RET(obj, member, type, ret) do { \
-    (void)static_cast<QTEXTRA_RET_ARG(t) ret (QTEXTRA_CLASSTYPE(obj) ::*)(int)>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret);\
+    (void)static_cast<QTEXTRA_RET_ARG(t) ret (QTEXTRA_CLASSTYPE(obj) ::*)()>(QTEXTRA_CLASSMEMBERREF(obj, member));\
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, );\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret);\
 } while(0)
 
 #define QTMETAMETHOD_INVOKE_RET_ARGS1(obj, member, type, ret, val0) do { \
     (void)static_cast<QTEXTRA_RET_ARG(t) ret (QTEXTRA_CLASSTYPE(obj) ::*)( \
         QTEXTRA_ARG(t) val0 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0 \
         );\
 } while(0)
@@ -326,7 +385,9 @@
         QTEXTRA_ARG(t) val0, \
         QTEXTRA_ARG(t) val1 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1 \
         );\
@@ -338,7 +399,9 @@
         QTEXTRA_ARG(t) val1, \
         QTEXTRA_ARG(t) val2 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2 \
@@ -352,7 +415,9 @@
         QTEXTRA_ARG(t) val2, \
         QTEXTRA_ARG(t) val3 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -368,7 +433,9 @@
         QTEXTRA_ARG(t) val3, \
         QTEXTRA_ARG(t) val4 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -386,7 +453,9 @@
         QTEXTRA_ARG(t) val4, \
         QTEXTRA_ARG(t) val5 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -406,7 +475,9 @@
         QTEXTRA_ARG(t) val5, \
         QTEXTRA_ARG(t) val6 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -428,7 +499,9 @@
         QTEXTRA_ARG(t) val6, \
         QTEXTRA_ARG(t) val7 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -452,7 +525,9 @@
         QTEXTRA_ARG(t) val7, \
         QTEXTRA_ARG(t) val8 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7, QTEXTRA_ARG(t) val8);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
@@ -478,7 +553,9 @@
         QTEXTRA_ARG(t) val8, \
         QTEXTRA_ARG(t) val9 \
         )>(QTEXTRA_CLASSMEMBERREF(obj, member));\
-    QMetaObject::invokeMethod(obj, #member, type, QTEXTRA_RET_ARG(qarg) ret, \
+    static const QMetaMethod qtextra_method = QTEXTRA_METAMETHOD(obj, member, QTEXTRA_ARG(t) val0, QTEXTRA_ARG(t) val1, QTEXTRA_ARG(t) val2, QTEXTRA_ARG(t) val3, QTEXTRA_ARG(t) val4, QTEXTRA_ARG(t) val5, QTEXTRA_ARG(t) val6, QTEXTRA_ARG(t) val7, QTEXTRA_ARG(t) val8, QTEXTRA_ARG(t) val9);\
+    QTEXTRA_TRACE_INVOKE(obj, member);\
+    qtextra_method.invoke(obj, type, QTEXTRA_RET_ARG(qarg) ret, \
         QTEXTRA_ARG(qarg) val0, \
         QTEXTRA_ARG(qarg) val1, \
         QTEXTRA_ARG(qarg) val2, \
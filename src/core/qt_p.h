@@ -9,6 +9,9 @@
 #define QTEXTRA_QT_P_H
 
 #include <qglobal.h>
+#include <qmetaobject.h>
+#include <type_traits>
+#include "trace.h"
 #if (QT_VERSION < QT_VERSION_CHECK(5, 7, 0))
 # error "Qt version 5.7 or later required"
 #endif
@@ -21,7 +24,34 @@
 #define QTEXTRA_RET_ARG_qarg(type, value) Q_RETURN_ARG(type, value)
 #define QTEXTRA_RET_ARG_t(type, value) type
 
+#define QTEXTRA_STRINGIFY(...) QTEXTRA_STRINGIFY_(__VA_ARGS__)
+#define QTEXTRA_STRINGIFY_(...) #__VA_ARGS__
+
 #define QTEXTRA_CLASSTYPE(obj) std::remove_reference<decltype(*(obj))>::type
 #define QTEXTRA_CLASSMEMBERREF(obj, member) & QTEXTRA_CLASSTYPE(obj) ::member
 
+// Arguments after "member" are argument types (expanded before stringifying)
+#define QTEXTRA_METAMETHOD(obj, member, ...) \
+    QtExtraPrivate::resolveMetaMethod<QTEXTRA_CLASSTYPE(obj)>(#member "(" QTEXTRA_STRINGIFY(__VA_ARGS__) ")")
+
+// Probe fired by every macro dispatch (see trace.h)
+#define QTEXTRA_TRACE_INVOKE(obj, member) \
+    QTEXTRA_TRACE2(invoke, static_cast<const void *>(obj), #member)
+
+namespace QtExtraPrivate {
+
+template <class T>
+QMetaMethod resolveMetaMethod(const char *signature)
+{
+    const QMetaObject &meta_object = T::staticMetaObject;
+    int index = meta_object.indexOfMethod(QMetaObject::normalizedSignature(signature).constData());
+    Q_ASSERT_X(index != -1, "QTMETAMETHOD_INVOKE", signature);
+    // Invalid method makes every dispatch fail silently, so report it in release builds too
+    if (index == -1)
+        qWarning("QTMETAMETHOD_INVOKE: no such method %s::%s", meta_object.className(), signature);
+    return meta_object.method(index);
+}
+
+} // namespace QtExtraPrivate
+
 #endif // QTEXTRA_QT_P_H
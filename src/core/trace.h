@@ -0,0 +1,88 @@
+/**
+ * @file    trace.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Compile-time switchable tracing probes
+ */
+
+#ifndef QTEXTRA_TRACE_H
+#define QTEXTRA_TRACE_H
+
+#include <qglobal.h>
+
+/**
+ * \defgroup QTEXTRA_TRACE Tracing probes
+ *
+ * Set of QTEXTRA_TRACE* macros marks hot-path events (tunnel data transfers, wrapped operations,
+ * channel state changes, QTMETAMETHOD_INVOKE_* and QtExtra::invoke dispatches)
+ * for correlating them with application events in external tracer.
+ *
+ * Probes are compiled in only if QTEXTRA_TRACE_ENABLED macro is defined
+ * (for "dbus" module it's done with "CONFIG += qtextra_trace" in qmake project), otherwise they expand to nothing
+ * and their arguments aren't evaluated.
+ * Backend is Linux USDT (statically defined tracing, see <sys/sdt.h> from systemtap-sdt-dev package):
+ * every probe is single "nop" instruction until tracer attaches to it, so tracing build is suitable for production,
+ * as long as probe arguments are cheap to evaluate (they're always evaluated).
+ * Probes belong to "qtextra" provider and are listed with
+ * \code
+ * readelf -n <binary> | grep -A2 qtextra
+ * \endcode
+ * and may be consumed by perf, bpftrace, SystemTap or LTTng (USDT support), for example:
+ * \code
+ * bpftrace -e 'usdt:./app:qtextra:relay_end { @bytes[arg1] = hist(arg2); }'
+ * \endcode
+ *
+ * QTEXTRA_TRACE<count>(name, ...)
+ *  - defines probe "name" with <count> (up to 4) integer or pointer arguments
+ *
+ * Probes defined by QtExtra modules (first argument is always object pointer):
+ * - invoke(object, method name) - QTMETAMETHOD_INVOKE_* macro or QtExtra::invoke template dispatch;
+ * - post_queued(object) - QtExtra::postQueued() (and invokeQueued() with member pointer) call;
+ * - relay_begin(tunnel, direction), relay_end(tunnel, direction, bytes) - RemoteDBusConnection tunnel
+ *   regular relay transfer (direction: 0 - remote to local side, 1 - local to remote side);
+ * - relay_splice(tunnel, direction, bytes) - zero-copy relay move;
+ * - wrapped_operation_start(tunnel, slot), wrapped_operation_stop(tunnel, slot, timed out),
+ *   wrapped_operation_timeout(tunnel, slot) - RemoteDBusConnection wrapped operations;
+ * - channel_state(tunnel, QAbstractSocket::SocketState), channel_opened(tunnel, success),
+ *   channel_closed(tunnel, success) - RemoteDBusConnection tunnel channel changes.
+ */
+/**@{*/
+
+#ifdef QTEXTRA_TRACE_ENABLED
+
+#if !defined(Q_OS_LINUX)
+# error "QTEXTRA_TRACE_ENABLED requires Linux (USDT backend)"
+#endif
+#if defined(__has_include)
+# if !__has_include(<sys/sdt.h>)
+#  error "QTEXTRA_TRACE_ENABLED requires <sys/sdt.h> (install systemtap-sdt-dev or equivalent package)"
+# endif
+#endif
+#include <sys/sdt.h>
+
+#define QTEXTRA_TRACE(name) \
+    DTRACE_PROBE(qtextra, name)
+#define QTEXTRA_TRACE1(name, val0) \
+    DTRACE_PROBE1(qtextra, name, val0)
+#define QTEXTRA_TRACE2(name, val0, val1) \
+    DTRACE_PROBE2(qtextra, name, val0, val1)
+#define QTEXTRA_TRACE3(name, val0, val1, val2) \
+    DTRACE_PROBE3(qtextra, name, val0, val1, val2)
+#define QTEXTRA_TRACE4(name, val0, val1, val2, val3) \
+    DTRACE_PROBE4(qtextra, name, val0, val1, val2, val3)
+
+#else
+
+// Arguments are referenced (so variables computed only for probes don't trigger warnings), but never evaluated
+#define QTEXTRA_TRACE(name) do {} while(0)
+#define QTEXTRA_TRACE1(name, val0) do { if (false) { (void)(val0); } } while(0)
+#define QTEXTRA_TRACE2(name, val0, val1) do { if (false) { (void)(val0); (void)(val1); } } while(0)
+#define QTEXTRA_TRACE3(name, val0, val1, val2) do { if (false) { (void)(val0); (void)(val1); (void)(val2); } } while(0)
+#define QTEXTRA_TRACE4(name, val0, val1, val2, val3) \
+    do { if (false) { (void)(val0); (void)(val1); (void)(val2); (void)(val3); } } while(0)
+
+#endif // QTEXTRA_TRACE_ENABLED
+
+/**@}*/ // end of QTEXTRA_TRACE
+
+#endif // QTEXTRA_TRACE_H
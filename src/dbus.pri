@@ -9,8 +9,16 @@
 lessThan(QT_MAJOR_VERSION, 5) | lessThan(QT_MINOR_VERSION, 7): error("Qt version 5.7 or later required")
 !contains(QT, dbus) | !contains(QT, network): error("Qt dbus and network modules must be included")
 
+# Tracing probes (see core/trace.h), enabled with "CONFIG += qtextra_trace" (Linux only, requires <sys/sdt.h>)
+qtextra_trace: DEFINES += QTEXTRA_TRACE_ENABLED
+
 SOURCES += \
-    $$PWD/dbus/remotedbusconnection.cpp
+    $$PWD/dbus/remotedbusconnection.cpp \
+    $$PWD/dbus/remotedbusconnectionpool.cpp \
+    $$PWD/dbus/remotedbusrelay.cpp
 
 HEADERS += \
-    $$PWD/dbus/remotedbusconnection.h
+    $$PWD/dbus/remotedbusconnection.h \
+    $$PWD/dbus/remotedbusconnectionpool.h \
+    $$PWD/dbus/remotedbusframing_p.h \
+    $$PWD/dbus/remotedbusrelay.h
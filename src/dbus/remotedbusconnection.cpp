@@ -6,25 +6,106 @@
  */
 
 #include <qglobal.h>
+#include <memory>
+#include <random>
 #ifdef Q_OS_LINUX
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <stddef.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #endif
+#include <qalgorithms.h>
+#include <qatomic.h>
+#include <qelapsedtimer.h>
 #include <qmutex.h>
-#include <qsemaphore.h>
+#include <qpointer.h>
+#include <qrunnable.h>
+#include <qthreadpool.h>
+#include <qvector.h>
+#include <qwaitcondition.h>
+#include <qsocketnotifier.h>
+#include <qcoreapplication.h>
+#include <qdbusconnectioninterface.h>
 #include <qdbuserror.h>
+#include <qdbusmessage.h>
+#include <qdbuspendingcall.h>
+#include <qdbusvirtualobject.h>
+#include <qeventloop.h>
+#include <qhash.h>
+#include <qhostaddress.h>
+#include <qhostinfo.h>
+#include <qlocalserver.h>
+#include <qlocalsocket.h>
 #include <qtcpsocket.h>
+#ifndef QT_NO_SSL
+#include <qsslsocket.h>
+#endif
 #include <qtcpserver.h>
 #include <qtimer.h>
+#include "../core/invoke.h"
 #include "../core/qt.h"
+#include "../core/trace.h"
 #include "remotedbusconnection.h"
+#include "remotedbusframing_p.h"
 
 namespace QtExtra {
 
+// Remote connection socket, it's TLS capable when Qt built with SSL support
+#ifndef QT_NO_SSL
+typedef QSslSocket RemoteSocket;
+#else
+typedef QTcpSocket RemoteSocket;
+#endif
+
+// Happy eyeballs connect (RFC 8305) parameters
+static const int connection_attempt_delay_ms = 250;
+static const qint64 resolved_addresses_lifetime_ms = 5 * 60 * 1000;
+
+// Maximum number of wrapped operations in progress simultaneously
+static const int wrapped_operation_slot_count = 64;
+
+// Lock-free logarithmic histogram: each power of two range is split into 4 linear sub-buckets
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+    void record(qint64 value_us);
+    void reset();
+    RemoteDBusConnection::LatencyPercentiles percentiles() const;
+
+private:
+    static const int sub_buckets_bits = 2;
+    static const int sub_buckets_count = 1 << sub_buckets_bits;
+    static const int buckets_count = 40 * sub_buckets_count; // up to ~2^40 us
+    static int bucketIndex(quint64 value);
+    static qint64 bucketUpperBound(int index);
+
+    QAtomicInteger<quint64> counts[buckets_count];
+    QAtomicInteger<qint64> max_value;
+};
+
+// Counters bumped from tunnel and wrapped operation threads
+struct StatisticsCounters {
+    QAtomicInteger<quint64> bytes_remote_to_local, bytes_local_to_remote;
+    QAtomicInteger<quint64> wrapped_operations, wrapped_operations_failed, wrapped_operations_timed_out;
+    QAtomicInteger<quint64> wrapped_operation_slot_waits;
+    QAtomicInteger<qint64> wrapped_operation_slot_wait_us;
+    LatencyHistogram wrapped_operation_latency;
+    QAtomicInteger<quint64> connections_opened, connection_attempts_failed, wrapped_operation_teardowns;
+    QAtomicInteger<quint64> connections_closed_idle;
+    QAtomicInteger<qint64> last_connect_duration_us, last_handshake_duration_us;
+    QAtomicInteger<quint64> reply_cache_hits, reply_cache_misses;
+    QAtomicInteger<quint64> async_call_window_waits, async_call_window_timeouts;
+    QAtomicInteger<quint64> heartbeat_failures;
+    QAtomicInteger<qint64> last_heartbeat_rtt_us;
+};
+
 class RemoteDBusConnectionTunnel : public QObject
 {
     Q_OBJECT
@@ -34,6 +115,14 @@ public:
         bool active;
         int keepcnt, keepidle, keepintvl;
     };
+
+    struct SpliceRelay {
+        QIODevice *src_socket;
+        int src_fd, dest_fd;
+        int pipe_fds[2];
+        qint64 pipe_size;
+        QSocketNotifier *src_notifier, *dest_notifier;
+    };
 #endif
 
     RemoteDBusConnectionTunnel();
@@ -44,56 +133,449 @@ public Q_SLOTS:
     void closeChannel();
     void abortChannel();
     void setRemoteSocketOption(QAbstractSocket::SocketOption option, const QVariant &value);
+    QAbstractSocket::SocketState remoteSocketState() const;
+    void prepareRemoteSocket(const QString &remote_hostname);
+    void connectRemoteSocket(const QString &remote_hostname, quint16 remote_port, QAbstractSocket::NetworkLayerProtocol remote_protocol);
+    void startConnectionRace(const QList<QHostAddress> &addresses);
+    void stopConnectionRace();
+    void processHostLookedUp(const QHostInfo &host_info);
+    void startNextConnectionAttempt();
+    void processConnectionAttemptConnected();
+    void processConnectionAttemptError();
+    void takeOverConnectionAttempt(QTcpSocket *socket);
+    void takeOverRemoteSocketDescriptor(int sd);
+#ifdef Q_OS_LINUX
+    bool startFastOpenConnect(const QString &remote_hostname, quint16 remote_port,
+                              QAbstractSocket::NetworkLayerProtocol remote_protocol);
+    void processFastOpenConnected();
+    void stopFastOpenConnect();
+    void confirmFastOpenConnect();
+#endif
+    void activateRelaySettings();
+    void failChannelOpening();
+    void startLocalRelay();
+    void applySocketBufferSizes(QIODevice *socket);
 #ifdef Q_OS_LINUX
     void applyRemoteSocketKeepaliveParams();
+    void applyRemoteSocketCongestionControl();
+    void setRemoteSocketCorked(bool corked);
+    void rearmRemoteSocketQuickAck();
 #endif
     void startConnectionTimer();
     void processRemoteSocketConnected();
     void processRemoteSocketDisconnected();
     void processRemoteSocketError();
+#ifndef QT_NO_SSL
+    void processRemoteSocketSslErrors(const QList<QSslError> &errors);
+    void storeSslSessionTicket();
+    bool isSslHandshakeInProgress() const;
+#endif
     void processConnectionTimeout();
     void processConnectionFailure(bool socket_error);
     void disconnectRemoteSocket(bool graceful);
     bool startLocalServer();
     void stopLocalServer();
     void processLocalServerNewConnection();
+    void processLocalUnixServerNewConnection();
+    void setupLocalSocket(QIODevice *socket);
     void processRemoteSocketReadyRead();
     void processLocalSocketReadyRead();
-    void transferDataFromSocketToSocket(QTcpSocket *src_socket, QTcpSocket *dest_socket);
-    void syncStartWrappedOperation();
-    void asyncStopWrappedOperation();
-    bool isWrappedOperationTimedOut();
+    void processRemoteSocketBytesWritten();
+    void processLocalSocketBytesWritten();
+    void transferDataFromSocketToSocket(QIODevice *src_socket, QIODevice *dest_socket);
+    qint64 transferDataChunk(QIODevice *src_socket, QIODevice *dest_socket);
+#ifdef Q_OS_LINUX
+    bool startSpliceRelay();
+    void stopSpliceRelay();
+    void processRemoteSocketSpliceReadable();
+    void processRemoteSocketSpliceWritable();
+    void processLocalSocketSpliceReadable();
+    void processLocalSocketSpliceWritable();
+    void transferDataBySplice(SpliceRelay *relay);
+#endif
+    int startWrappedOperation(int timeout_ms);
+    int occupyWrappedOperationSlot(qint64 start_ms);
+    bool stopWrappedOperation(int slot);
+    bool isWrappedOperationInProgress();
+    bool reserveAsyncCall(int window, int timeout_ms);
+    void cancelAsyncCallReservation();
+    void trackAsyncCall(const QDBusPendingCall &call, bool reserved);
+    bool hasOutstandingAsyncCalls();
+    void updateWrappedOperationWatchdog();
+    void checkWrappedOperationDeadline();
     void processWrappedOperationTimeout();
+    void dropChannel();
 
 Q_SIGNALS:
-    void channelOpened(bool success, quint16 local_port = 0);
+    void channelOpened(bool success, const QString &local_address = QString());
     void channelError(const QString &message);
     void channelClosed(bool success);
 
 public:
     QMutex mutex;
-    int connection_timeout_ms, wrapped_operation_timeout_ms;
-    QSemaphore wrapped_operation_semaphore;
-    bool wrapped_operation_timed_out;
-    QTcpSocket remote_socket;
-    QTcpSocket *local_socket;
+    int connection_timeout_ms;
+    QAtomicInt wrapped_operation_timeout_ms;
+    QAtomicInt wrapped_operation_timeout_policy;
+    QElapsedTimer wrapped_operation_clock;
+    QAtomicInteger<qint64> wrapped_operation_slots[wrapped_operation_slot_count];
+    // Used only by threads waiting for free slot, finishing operation wakes them
+    QMutex wrapped_operation_mutex;
+    QWaitCondition wrapped_operation_finished;
+    QAtomicInt wrapped_operation_waiters;
+    // Calls window of RemoteDBusConnection::asyncCall() and idle check, calls are watched in this object thread
+    QMutex async_calls_mutex;
+    QWaitCondition async_call_finished;
+    int outstanding_async_calls; // sent, but not finished yet
+    int reserved_async_calls; // passed window check, but not sent yet
+    StatisticsCounters statistics;
+    QElapsedTimer connect_clock;
+    bool happy_eyeballs_enabled;
+    bool early_channel_open_enabled;
+    bool channel_opened_early; // channelOpened() emitted before remote socket connected
+    bool connection_race_active;
+    int connection_race_lookup_id;
+    QString connection_race_hostname;
+    quint16 connection_race_port;
+    QList<QHostAddress> connection_race_addresses;
+    QList<QTcpSocket *> connection_race_sockets;
+    QTimer connection_race_timer;
+    struct ResolvedAddresses {
+        QList<QHostAddress> addresses; // host connected last time goes first
+        qint64 expiry_ms;
+    };
+    QHash<QString, ResolvedAddresses> resolved_addresses_cache;
+    QElapsedTimer resolved_addresses_clock;
+    QHash<int, QVariant> remote_socket_options;
+    RemoteSocket remote_socket;
+    QIODevice *local_socket;
     QTcpServer local_server;
-    QTimer connection_timer, wrapped_operation_timer;
+    QLocalServer local_unix_server;
+    RemoteDBusConnection::LocalTransport local_transport, active_local_transport;
+    QString local_address;
+    QTimer connection_timer, wrapped_operation_watchdog;
+    qint64 relay_high_watermark, relay_low_watermark;
+    qint64 active_relay_high_watermark, active_relay_low_watermark;
+    bool remote_to_local_paused, local_to_remote_paused;
+    int socket_send_buffer_size, socket_receive_buffer_size;
+    int relay_chunk_size, active_relay_chunk_size;
+    QByteArray remote_to_local_buffer, local_to_remote_buffer;
+    bool compression_enabled;
+    int compression_level;
+    bool compression_active;
+    RelayFrameEncoder frame_encoder;
+    RelayFrameDecoder frame_decoder;
+#ifndef QT_NO_SSL
+    bool ssl_enabled;
+    QSslConfiguration ssl_configuration;
+    bool ssl_active;
+    QString ssl_session_hostname;
+    QByteArray ssl_session_ticket;
+#endif
 #ifdef Q_OS_LINUX
     KeepaliveParams keepalive_params;
+    QAtomicInt tcp_quickack_enabled, tcp_cork_enabled;
+    int remote_socket_cork_depth; // batches in progress, socket is corked while it's non-zero
+    QByteArray congestion_control;
+    bool fast_open_enabled;
+    int fast_open_sd;
+    QSocketNotifier *fast_open_notifier;
+    bool fast_open_connect_pending; // adopted with deferred SYN, not confirmed by remote side yet
+    bool splice_relay_enabled;
+    bool splice_relay_active;
+    SpliceRelay remote_to_local_relay, local_to_remote_relay;
+    int splice_remote_fd, splice_local_fd; // duplicates of sockets descriptors owned by relay
 #endif
 };
 
+// Fixed set of threads shared by tunnels of RemoteDBusConnection::SharedTunnelThread instances.
+// Threads are started on first use and live until application exit.
+class RemoteDBusConnectionTunnelPool
+{
+public:
+    RemoteDBusConnectionTunnelPool();
+    ~RemoteDBusConnectionTunnelPool();
+    QThread *acquireThread();
+    void releaseThread(QThread *thread);
+
+private:
+    QMutex mutex;
+    QVector<QThread *> threads;
+    QVector<int> tunnels_count;
+};
+
+Q_GLOBAL_STATIC(RemoteDBusConnectionTunnelPool, tunnel_pool)
+
+// Handshakes mostly wait for network round trips, so pool is larger than usual CPU-bound one
+// and separated from QThreadPool::globalInstance() to not starve application tasks.
+static const int handshake_max_thread_count = 32;
+
+class RemoteDBusConnectionHandshakePool : public QThreadPool
+{
+public:
+    RemoteDBusConnectionHandshakePool() {setMaxThreadCount(handshake_max_thread_count);}
+};
+
+Q_GLOBAL_STATIC(RemoteDBusConnectionHandshakePool, handshake_pool)
+// Runs operations abandoned at deadline (see RemoteDBusConnection::AbandonOperationOnTimeout)
+Q_GLOBAL_STATIC(RemoteDBusConnectionHandshakePool, abandonable_operation_pool)
+
+// Wrapped operation executed out of calling thread, so caller may stop waiting for it at deadline.
+// It owns everything it uses (connection handle included), since it may outlive caller.
+class RemoteDBusConnectionAbandonableOperation : public QRunnable
+{
+public:
+    struct State {
+        QSemaphore finished;
+        bool success;
+        QDBusError error;
+    };
+
+    RemoteDBusConnectionAbandonableOperation(const std::shared_ptr<State> &state, const QDBusConnection &connection,
+                                             const std::function<bool (QDBusConnection &)> &operation) :
+        state(state), connection(connection), operation(operation) {}
+    void run() override
+    {
+        state->success = operation(connection);
+        if (!state->success)
+            state->error = connection.lastError();
+        state->finished.release();
+    }
+
+private:
+    std::shared_ptr<State> state;
+    QDBusConnection connection;
+    std::function<bool (QDBusConnection &)> operation;
+};
+
+// Performs blocking QDBusConnection::connectToBus() out of RemoteDBusConnection thread.
+// Result is queued back to processHandshakeFinished(), which is never delivered if object destroyed meanwhile
+// (destructor waits for handshake_finished semaphore, so object outlives run()).
+class RemoteDBusConnectionHandshake : public QRunnable
+{
+public:
+    RemoteDBusConnectionHandshake(RemoteDBusConnection *connection, const QString &dbus_address) :
+        connection(connection), dbus_address(dbus_address) {}
+    void run() override
+    {
+        QElapsedTimer handshake_clock;
+        handshake_clock.start();
+        QDBusConnection *ref = new QDBusConnection(QDBusConnection::connectToBus(dbus_address, connection->ref_name));
+        Q_CHECK_PTR(ref);
+        connection->tunnel->statistics.last_handshake_duration_us.store(handshake_clock.nsecsElapsed() / 1000);
+        connection->handshake_ref = ref;
+        QTMETAMETHOD_INVOKE_QUEUED(connection, processHandshakeFinished);
+        connection->handshake_finished.release();
+    }
+
+private:
+    RemoteDBusConnection *connection;
+    QString dbus_address;
+};
+
+// Used when chunk size isn't set with RemoteDBusConnection::setRelayChunkSize()
+static const int relay_default_chunk_size = 65536;
+#ifdef Q_OS_LINUX
+static const int splice_relay_max_rounds = 16;
+#endif
+
+static const char dbus_daemon_service[] = "org.freedesktop.DBus";
+static const char dbus_daemon_path[] = "/org/freedesktop/DBus";
+static const char dbus_daemon_interface[] = "org.freedesktop.DBus";
+static const uint dbus_name_flag_do_not_queue = 0x4;
+static const uint dbus_request_name_reply_primary_owner = 1;
+static const uint dbus_request_name_reply_already_owner = 4;
+static const char dbus_properties_interface[] = "org.freedesktop.DBus.Properties";
+static const char dbus_introspectable_interface[] = "org.freedesktop.DBus.Introspectable";
+
+// Rule isn't parsed (values may contain separators), so only surrounding whitespace is ignored
+static QString normalizedMatchRule(const QString &rule)
+{
+    return rule.trimmed();
+}
+
+// Returns key of cacheable call (property read or introspection), empty string otherwise
+static QString replyCacheKey(const QDBusMessage &message, bool *introspection)
+{
+    if ((message.type() != QDBusMessage::MethodCallMessage) || message.service().isEmpty())
+        return QString();
+    const QList<QVariant> arguments = message.arguments();
+    QString key = message.service() + '\n' + message.path() + '\n' + message.interface() + '\n' + message.member();
+    if (message.interface() == QLatin1String(dbus_introspectable_interface)) {
+        if ((message.member() != QLatin1String("Introspect")) || !arguments.isEmpty())
+            return QString();
+        *introspection = true;
+        return key;
+    }
+    if (message.interface() != QLatin1String(dbus_properties_interface))
+        return QString();
+    if (!(((message.member() == QLatin1String("Get")) && (arguments.size() == 2)) ||
+          ((message.member() == QLatin1String("GetAll")) && (arguments.size() == 1))))
+        return QString();
+    for (const QVariant &argument : arguments)
+        key += '\n' + argument.toString();
+    *introspection = false;
+    return key;
+}
+
+// Idle connection check is done this number of times per idle timeout period
+static const int idle_check_resolution = 4;
+
+// QtDBus reply timeout used when call timeout isn't set (same as libdbus one)
+static const int dbus_default_call_timeout_ms = 25000;
+
+// Values of RemoteDBusConnectionTunnel::wrapped_operation_slots other than operation start timestamp
+static const qint64 wrapped_operation_idle = -1;
+static const qint64 wrapped_operation_timed_out = -2;
+// Watchdog checks deadlines this number of times per timeout period
+static const int wrapped_operation_watchdog_resolution = 4;
+
+// Local connection socket is either QTcpSocket or QLocalSocket, which have no common API except QIODevice
+
+static qintptr socketDescriptor(QIODevice *socket)
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket))
+        return abstract_socket->socketDescriptor();
+    if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket))
+        return local_socket->socketDescriptor();
+    return -1;
+}
+
+static void setSocketReadBufferSize(QIODevice *socket, qint64 size)
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket))
+        abstract_socket->setReadBufferSize(size);
+    else if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket))
+        local_socket->setReadBufferSize(size);
+}
+
+static bool flushSocket(QIODevice *socket)
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket))
+        return abstract_socket->flush();
+    if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket))
+        return local_socket->flush();
+    return false;
+}
+
+static void abortSocket(QIODevice *socket)
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket))
+        abstract_socket->abort();
+    else if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket))
+        local_socket->abort();
+}
+
+#if !defined(Q_OS_LINUX) || (QT_VERSION < QT_VERSION_CHECK(5, 10, 0))
+static QString escapeDBusAddressValue(const QString &value)
+{
+    // See "Server Addresses" section of D-Bus specification
+    static const char hex_digits[] = "0123456789abcdef";
+    QByteArray bytes = value.toUtf8();
+    QString result;
+    for (int i = 0; i < bytes.size(); i++) {
+        char c = bytes.at(i);
+        if (((c >= '0') && (c <= '9')) || ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) ||
+            (c == '-') || (c == '_') || (c == '/') || (c == '.') || (c == '\\') || (c == '*')) {
+            result.append(QChar(c));
+        } else {
+            result.append(QChar('%'));
+            result.append(QChar(hex_digits[(uchar)c >> 4]));
+            result.append(QChar(hex_digits[(uchar)c & 0xf]));
+        }
+    }
+    return result;
+}
+#endif
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 value_us)
+{
+    if (value_us < 0)
+        value_us = 0;
+    counts[bucketIndex(quint64(value_us))].fetchAndAddRelaxed(1);
+    qint64 max = max_value.loadAcquire();
+    while ((value_us > max) && !max_value.testAndSetOrdered(max, value_us, max)) {}
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i = 0; i < buckets_count; i++)
+        counts[i].store(0);
+    max_value.store(0);
+}
+
+RemoteDBusConnection::LatencyPercentiles LatencyHistogram::percentiles() const
+{
+    quint64 snapshot[buckets_count];
+    quint64 total = 0;
+    for (int i = 0; i < buckets_count; i++) {
+        snapshot[i] = counts[i].load();
+        total += snapshot[i];
+    }
+    RemoteDBusConnection::LatencyPercentiles result;
+    result.count = total;
+    result.max_us = max_value.load();
+    qint64 *targets[] = {&result.p50_us, &result.p90_us, &result.p99_us, &result.p999_us};
+    const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    quint64 cumulative = 0;
+    int index = 0;
+    for (int q = 0; q < 4; q++) {
+        quint64 rank = quint64(quantiles[q] * total + 0.999999);
+        while ((index < buckets_count - 1) && (cumulative + snapshot[index] < rank))
+            cumulative += snapshot[index++];
+        *targets[q] = (total == 0) ? 0 : qMin(bucketUpperBound(index), result.max_us);
+    }
+    return result;
+}
+
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+    if (value < sub_buckets_count)
+        return int(value);
+    int msb = 63 - int(qCountLeadingZeroBits(value));
+    int sub_bucket = int(value >> (msb - sub_buckets_bits)) & (sub_buckets_count - 1);
+    int index = (msb - sub_buckets_bits + 1) * sub_buckets_count + sub_bucket;
+    return qMin(index, buckets_count - 1);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < sub_buckets_count)
+        return index;
+    int shift = index / sub_buckets_count - 1;
+    qint64 lower = qint64(sub_buckets_count + index % sub_buckets_count) << shift;
+    return lower + (qint64(1) << shift) - 1;
+}
+
 RemoteDBusConnectionTunnel::RemoteDBusConnectionTunnel() :
     QObject(0),
     connection_timeout_ms(-1), wrapped_operation_timeout_ms(-1),
-    wrapped_operation_semaphore(1),
-    wrapped_operation_timed_out(false),
+    wrapped_operation_timeout_policy(RemoteDBusConnection::DropConnectionOnTimeout),
+    outstanding_async_calls(0), reserved_async_calls(0),
+    happy_eyeballs_enabled(false), early_channel_open_enabled(false), channel_opened_early(false),
+    connection_race_active(false), connection_race_lookup_id(-1),
+    connection_race_port(0), connection_race_timer(this),
     remote_socket(this),
-    local_socket(nullptr), local_server(this),
-    connection_timer(this), wrapped_operation_timer(this)
+    local_socket(nullptr), local_server(this), local_unix_server(this),
+    local_transport(RemoteDBusConnection::LocalTcpTransport),
+    active_local_transport(RemoteDBusConnection::LocalTcpTransport),
+    connection_timer(this), wrapped_operation_watchdog(this),
+    relay_high_watermark(0), relay_low_watermark(0),
+    active_relay_high_watermark(0), active_relay_low_watermark(0),
+    remote_to_local_paused(false), local_to_remote_paused(false),
+    socket_send_buffer_size(0), socket_receive_buffer_size(0),
+    relay_chunk_size(0), active_relay_chunk_size(0),
+    compression_enabled(false), compression_level(-1), compression_active(false)
+#ifndef QT_NO_SSL
+    , ssl_enabled(false), ssl_active(false)
+#endif
 {
     local_server.setMaxPendingConnections(1);
+    local_unix_server.setMaxPendingConnections(1);
 
     QObject::connect(&remote_socket, &QTcpSocket::connected,
                      this, &RemoteDBusConnectionTunnel::processRemoteSocketConnected);
@@ -101,22 +583,70 @@ RemoteDBusConnectionTunnel::RemoteDBusConnectionTunnel() :
                      this, &RemoteDBusConnectionTunnel::processRemoteSocketDisconnected);
     QObject::connect(&remote_socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
                      this, &RemoteDBusConnectionTunnel::processRemoteSocketError);
+#ifndef QT_NO_SSL
+    QObject::connect(&remote_socket, &QSslSocket::encrypted,
+                     this, &RemoteDBusConnectionTunnel::processRemoteSocketConnected);
+    QObject::connect(&remote_socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors),
+                     this, &RemoteDBusConnectionTunnel::processRemoteSocketSslErrors);
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+    // TLS 1.3 server sends session ticket after handshake completed
+    QObject::connect(&remote_socket, &QSslSocket::newSessionTicketReceived,
+                     this, &RemoteDBusConnectionTunnel::storeSslSessionTicket);
+#endif
+#endif
     QObject::connect(&remote_socket, &QTcpSocket::readyRead,
                      this, &RemoteDBusConnectionTunnel::processRemoteSocketReadyRead);
+    QObject::connect(&remote_socket, &QTcpSocket::bytesWritten,
+                     this, &RemoteDBusConnectionTunnel::processRemoteSocketBytesWritten);
 
     QObject::connect(&local_server, &QTcpServer::newConnection,
                      this, &RemoteDBusConnectionTunnel::processLocalServerNewConnection);
+    QObject::connect(&local_unix_server, &QLocalServer::newConnection,
+                     this, &RemoteDBusConnectionTunnel::processLocalUnixServerNewConnection);
 
     connection_timer.setSingleShot(true);
     QObject::connect(&connection_timer, &QTimer::timeout,
                      this, &RemoteDBusConnectionTunnel::processConnectionTimeout);
 
-    wrapped_operation_timer.setSingleShot(true);
-    QObject::connect(&wrapped_operation_timer, &QTimer::timeout,
-                     this, &RemoteDBusConnectionTunnel::processWrappedOperationTimeout);
+    connection_race_timer.setSingleShot(true);
+    QObject::connect(&connection_race_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnectionTunnel::startNextConnectionAttempt);
+    resolved_addresses_clock.start();
+
+    wrapped_operation_clock.start();
+    for (int i = 0; i < wrapped_operation_slot_count; i++)
+        wrapped_operation_slots[i].store(wrapped_operation_idle);
+    QObject::connect(&wrapped_operation_watchdog, &QTimer::timeout,
+                     this, &RemoteDBusConnectionTunnel::checkWrappedOperationDeadline);
+
+#ifdef QTEXTRA_TRACE_ENABLED
+    QObject::connect(&remote_socket, &QAbstractSocket::stateChanged,
+                     this, [this](QAbstractSocket::SocketState state) {
+        QTEXTRA_TRACE2(channel_state, this, int(state));
+    });
+    QObject::connect(this, &RemoteDBusConnectionTunnel::channelOpened,
+                     this, [this](bool success) {
+        QTEXTRA_TRACE2(channel_opened, this, int(success));
+    });
+    QObject::connect(this, &RemoteDBusConnectionTunnel::channelClosed,
+                     this, [this](bool success) {
+        QTEXTRA_TRACE2(channel_closed, this, int(success));
+    });
+#endif
 
 #ifdef Q_OS_LINUX
     keepalive_params.active = false;
+    tcp_quickack_enabled.store(0);
+    tcp_cork_enabled.store(1);
+    remote_socket_cork_depth = 0;
+    fast_open_enabled = false;
+    fast_open_sd = -1;
+    fast_open_notifier = nullptr;
+    fast_open_connect_pending = false;
+    splice_relay_enabled = false;
+    splice_relay_active = false;
+    splice_remote_fd = -1;
+    splice_local_fd = -1;
 #endif
 }
 
@@ -127,23 +657,387 @@ RemoteDBusConnectionTunnel::~RemoteDBusConnectionTunnel()
 
 void RemoteDBusConnectionTunnel::openChannel(const QString &remote_hostname, quint16 remote_port, QAbstractSocket::NetworkLayerProtocol remote_protocol)
 {
-    if (remote_socket.state() != QAbstractSocket::UnconnectedState)
+    if (remoteSocketState() != QAbstractSocket::UnconnectedState) {
         Q_EMIT channelOpened(false);
+        return;
+    }
 
+    activateRelaySettings();
     if (!startLocalServer()) {
         Q_EMIT channelError("Internal error: failed to start local server");
         Q_EMIT channelOpened(false);
+        return;
+    }
+
+    connect_clock.start();
+    prepareRemoteSocket(remote_hostname);
+
+    mutex.lock();
+    channel_opened_early = early_channel_open_enabled;
+    mutex.unlock();
+    if (channel_opened_early) {
+        // Local side doesn't depend on remote one, so D-Bus handshake starts while remote connect is in flight
+        Q_EMIT channelOpened(true, local_address);
+    }
+
+    mutex.lock();
+    bool use_happy_eyeballs = happy_eyeballs_enabled;
+    mutex.unlock();
+    // Racing makes sense only if host name may resolve to addresses of both families
+    if (!use_happy_eyeballs || (remote_protocol != QAbstractSocket::AnyIPProtocol)
+            || !QHostAddress(remote_hostname).isNull()) {
+        connectRemoteSocket(remote_hostname, remote_port, remote_protocol);
+        if (remote_socket.state() != QAbstractSocket::ConnectedState)
+            startConnectionTimer();
+        return;
+    }
+
+    connection_race_active = true;
+    connection_race_hostname = remote_hostname;
+    connection_race_port = remote_port;
+    startConnectionTimer();
+    auto cache_it = resolved_addresses_cache.constFind(remote_hostname);
+    if ((cache_it != resolved_addresses_cache.constEnd())
+            && (cache_it->expiry_ms > resolved_addresses_clock.elapsed())) {
+        startConnectionRace(cache_it->addresses);
+        return;
+    }
+    connection_race_lookup_id = QHostInfo::lookupHost(remote_hostname, this, SLOT(processHostLookedUp(QHostInfo)));
+}
+
+// Returns state, where connection race counts as remote socket connecting
+QAbstractSocket::SocketState RemoteDBusConnectionTunnel::remoteSocketState() const
+{
+#ifdef Q_OS_LINUX
+    if (fast_open_notifier != nullptr)
+        return QAbstractSocket::ConnectingState;
+#endif
+    return connection_race_active ? QAbstractSocket::ConnectingState : remote_socket.state();
+}
+
+// Opening failed before channel became usable
+void RemoteDBusConnectionTunnel::failChannelOpening()
+{
+    if (channel_opened_early) {
+        // Opening result is reported by D-Bus handshake, which fails since local side is closed
+        channel_opened_early = false;
+        return;
+    }
+    Q_EMIT channelOpened(false);
+}
+
+void RemoteDBusConnectionTunnel::prepareRemoteSocket(const QString &remote_hostname)
+{
+#ifndef QT_NO_SSL
+    mutex.lock();
+    ssl_active = ssl_enabled;
+    QSslConfiguration configuration = ssl_configuration;
+    mutex.unlock();
+    if (!ssl_active)
+        return;
+    // Resume previous session with same host, if server issued ticket
+    if (ssl_session_hostname != remote_hostname) {
+        ssl_session_hostname = remote_hostname;
+        ssl_session_ticket.clear();
     }
+    configuration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    if (!ssl_session_ticket.isEmpty())
+        configuration.setSessionTicket(ssl_session_ticket);
+    remote_socket.setSslConfiguration(configuration);
+    remote_socket.setPeerVerifyName(remote_hostname);
+#else
+    Q_UNUSED(remote_hostname);
+#endif
+}
 
+void RemoteDBusConnectionTunnel::connectRemoteSocket(const QString &remote_hostname, quint16 remote_port, QAbstractSocket::NetworkLayerProtocol remote_protocol)
+{
+#ifndef QT_NO_SSL
+    if (ssl_active) {
+        remote_socket.connectToHostEncrypted(remote_hostname, remote_port, ssl_session_hostname,
+                                             QIODevice::ReadWrite, remote_protocol);
+        return;
+    }
+#endif
+#ifdef Q_OS_LINUX
+    mutex.lock();
+    bool use_fast_open = fast_open_enabled;
+    mutex.unlock();
+    if (use_fast_open && startFastOpenConnect(remote_hostname, remote_port, remote_protocol))
+        return;
+#endif
     remote_socket.connectToHost(remote_hostname, remote_port, QIODevice::ReadWrite, remote_protocol);
+}
 
-    if (remote_socket.state() != QAbstractSocket::ConnectedState)
-        startConnectionTimer();
+#ifdef Q_OS_LINUX
+// With TCP_FASTOPEN_CONNECT kernel defers SYN until first write when it has server cookie,
+// so D-Bus authentication request travels in SYN and reply arrives one round trip earlier.
+// Without cookie, regular SYN requests it for next connections.
+// Socket is connected here and adopted by remote socket, since QTcpSocket can't set options before connect().
+bool RemoteDBusConnectionTunnel::startFastOpenConnect(const QString &remote_hostname, quint16 remote_port,
+                                                      QAbstractSocket::NetworkLayerProtocol remote_protocol)
+{
+#ifndef TCP_FASTOPEN_CONNECT
+    static const int TCP_FASTOPEN_CONNECT = 30;
+#endif
+    // Host name resolution would block here
+    QHostAddress address(remote_hostname);
+    if (address.isNull() || !address.scopeId().isEmpty())
+        return false;
+    if ((remote_protocol != QAbstractSocket::AnyIPProtocol) && (remote_protocol != address.protocol()))
+        return false;
+    struct sockaddr_in addr_in;
+    struct sockaddr_in6 addr_in6;
+    struct sockaddr *addr;
+    socklen_t addr_len;
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        memset(&addr_in, 0, sizeof(addr_in));
+        addr_in.sin_family = AF_INET;
+        addr_in.sin_port = htons(remote_port);
+        addr_in.sin_addr.s_addr = htonl(address.toIPv4Address());
+        addr = reinterpret_cast<struct sockaddr *>(&addr_in);
+        addr_len = sizeof(addr_in);
+    } else {
+        memset(&addr_in6, 0, sizeof(addr_in6));
+        addr_in6.sin6_family = AF_INET6;
+        addr_in6.sin6_port = htons(remote_port);
+        Q_IPV6ADDR ipv6_address = address.toIPv6Address();
+        memcpy(&addr_in6.sin6_addr, &ipv6_address, sizeof(addr_in6.sin6_addr));
+        addr = reinterpret_cast<struct sockaddr *>(&addr_in6);
+        addr_len = sizeof(addr_in6);
+    }
+    int sd = ::socket(addr->sa_family, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (sd == -1)
+        return false;
+    int optval = 1;
+    if (setsockopt(sd, SOL_TCP, TCP_FASTOPEN_CONNECT, &optval, sizeof(optval)) != 0) {
+        // Kernel doesn't support it (older than 4.11), use regular connect
+        ::close(sd);
+        return false;
+    }
+    if (::connect(sd, addr, addr_len) == 0) {
+        // Cookie is cached, SYN is deferred until first write (see confirmFastOpenConnect())
+        fast_open_connect_pending = true;
+        takeOverRemoteSocketDescriptor(sd);
+        return true;
+    }
+    if (errno != EINPROGRESS) {
+        ::close(sd);
+        return false;
+    }
+    fast_open_sd = sd;
+    fast_open_notifier = new QSocketNotifier(sd, QSocketNotifier::Write, this);
+    Q_CHECK_PTR(fast_open_notifier);
+    QObject::connect(fast_open_notifier, &QSocketNotifier::activated,
+                     this, &RemoteDBusConnectionTunnel::processFastOpenConnected);
+    return true;
+}
+
+void RemoteDBusConnectionTunnel::processFastOpenConnected()
+{
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+    if (getsockopt(fast_open_sd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0)
+        error = errno;
+    if (error != 0) {
+        char error_buf[255];
+        Q_EMIT channelError(QString("Remote connection error: %1 (%2)")
+                            .arg(error).arg(strerror_r(error, error_buf, sizeof(error_buf))));
+        processConnectionFailure(true);
+        return;
+    }
+    int sd = fast_open_sd;
+    fast_open_sd = -1;
+    fast_open_notifier->setEnabled(false);
+    fast_open_notifier->deleteLater();
+    fast_open_notifier = nullptr;
+    takeOverRemoteSocketDescriptor(sd);
+}
+
+void RemoteDBusConnectionTunnel::stopFastOpenConnect()
+{
+    if (fast_open_notifier == nullptr)
+        return;
+    fast_open_notifier->setEnabled(false);
+    fast_open_notifier->deleteLater();
+    fast_open_notifier = nullptr;
+    ::close(fast_open_sd);
+    fast_open_sd = -1;
+}
+
+// Connection adopted with deferred SYN is established only when remote side replies to first write,
+// so connect attempt lasts (and may time out) until then
+void RemoteDBusConnectionTunnel::confirmFastOpenConnect()
+{
+    if (!fast_open_connect_pending)
+        return;
+    fast_open_connect_pending = false;
+    connection_timer.stop();
+    statistics.last_connect_duration_us.store(connect_clock.nsecsElapsed() / 1000);
+}
+#endif
+
+void RemoteDBusConnectionTunnel::processHostLookedUp(const QHostInfo &host_info)
+{
+    if (host_info.lookupId() != connection_race_lookup_id)
+        return;
+    connection_race_lookup_id = -1;
+    if (host_info.error() != QHostInfo::NoError) {
+        Q_EMIT channelError(QString("Remote connection error: %1").arg(host_info.errorString()));
+        processConnectionFailure(true);
+        return;
+    }
+    ResolvedAddresses resolved;
+    resolved.addresses = host_info.addresses();
+    resolved.expiry_ms = resolved_addresses_clock.elapsed() + resolved_addresses_lifetime_ms;
+    resolved_addresses_cache.insert(connection_race_hostname, resolved);
+    startConnectionRace(resolved.addresses);
+}
+
+// Orders addresses interleaving families (IPv6 first, unless cached order says otherwise) and starts first attempt
+void RemoteDBusConnectionTunnel::startConnectionRace(const QList<QHostAddress> &addresses)
+{
+    QList<QHostAddress> first_family, second_family;
+    QAbstractSocket::NetworkLayerProtocol preferred_protocol = addresses.isEmpty() ?
+                QAbstractSocket::IPv6Protocol : addresses.first().protocol();
+    for (const QHostAddress &address : addresses) {
+        if (address.protocol() == preferred_protocol)
+            first_family.append(address);
+        else
+            second_family.append(address);
+    }
+    connection_race_addresses.clear();
+    while (!first_family.isEmpty() || !second_family.isEmpty()) {
+        if (!first_family.isEmpty())
+            connection_race_addresses.append(first_family.takeFirst());
+        if (!second_family.isEmpty())
+            connection_race_addresses.append(second_family.takeFirst());
+    }
+    startNextConnectionAttempt();
+}
+
+void RemoteDBusConnectionTunnel::stopConnectionRace()
+{
+    if (!connection_race_active)
+        return;
+    connection_race_active = false;
+    if (connection_race_lookup_id != -1) {
+        QHostInfo::abortHostLookup(connection_race_lookup_id);
+        connection_race_lookup_id = -1;
+    }
+    connection_race_timer.stop();
+    connection_race_addresses.clear();
+    for (QTcpSocket *socket : connection_race_sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+    connection_race_sockets.clear();
+}
+
+// Next attempt starts after delay or immediately after previous one failed
+void RemoteDBusConnectionTunnel::startNextConnectionAttempt()
+{
+    connection_race_timer.stop();
+    if (connection_race_addresses.isEmpty()) {
+        if (connection_race_sockets.isEmpty()) {
+            resolved_addresses_cache.remove(connection_race_hostname);
+            Q_EMIT channelError(QString("Remote connection error: failed to connect to any address of %1")
+                                .arg(connection_race_hostname));
+            processConnectionFailure(true);
+        }
+        return;
+    }
+    QTcpSocket *socket = new QTcpSocket(this);
+    Q_CHECK_PTR(socket);
+    connection_race_sockets.append(socket);
+    QObject::connect(socket, &QTcpSocket::connected,
+                     this, &RemoteDBusConnectionTunnel::processConnectionAttemptConnected);
+    QObject::connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
+                     this, &RemoteDBusConnectionTunnel::processConnectionAttemptError);
+    socket->connectToHost(connection_race_addresses.takeFirst(), connection_race_port);
+    if (!connection_race_addresses.isEmpty())
+        connection_race_timer.start(connection_attempt_delay_ms);
+}
+
+void RemoteDBusConnectionTunnel::processConnectionAttemptConnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    Q_ASSERT(socket != nullptr);
+    // Winner goes first next time
+    auto cache_it = resolved_addresses_cache.find(connection_race_hostname);
+    if (cache_it != resolved_addresses_cache.end()) {
+        cache_it->addresses.removeAll(socket->peerAddress());
+        cache_it->addresses.prepend(socket->peerAddress());
+    }
+    connection_race_sockets.removeOne(socket);
+    stopConnectionRace();
+    takeOverConnectionAttempt(socket);
+    socket->deleteLater();
+}
+
+void RemoteDBusConnectionTunnel::processConnectionAttemptError()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    Q_ASSERT(socket != nullptr);
+    connection_race_sockets.removeOne(socket);
+    socket->disconnect(this);
+    socket->deleteLater();
+    startNextConnectionAttempt();
+}
+
+// Makes remote socket use connection established by winning attempt
+void RemoteDBusConnectionTunnel::takeOverConnectionAttempt(QTcpSocket *socket)
+{
+#ifdef Q_OS_UNIX
+    int sd = ::dup(int(socket->socketDescriptor()));
+    socket->disconnect(this);
+    socket->abort();
+    takeOverRemoteSocketDescriptor(sd);
+#else
+    // Descriptor can't be shared, connect again to address known to work
+    QHostAddress address = socket->peerAddress();
+    socket->disconnect(this);
+    socket->abort();
+    connectRemoteSocket(address.toString(), connection_race_port, address.protocol());
+#endif
+}
+
+// Makes remote socket use already connected descriptor
+void RemoteDBusConnectionTunnel::takeOverRemoteSocketDescriptor(int sd)
+{
+#ifdef Q_OS_UNIX
+    if ((sd == -1) || !remote_socket.setSocketDescriptor(sd, QAbstractSocket::ConnectedState)) {
+        if (sd != -1)
+            ::close(sd);
+        Q_EMIT channelError("Internal error: failed to take over remote connection");
+#ifdef Q_OS_LINUX
+        fast_open_connect_pending = false;
+#endif
+        connection_timer.stop();
+        stopLocalServer();
+        failChannelOpening();
+        return;
+    }
+    // Options set before aren't applied to adopted descriptor
+    for (auto it = remote_socket_options.constBegin(); it != remote_socket_options.constEnd(); ++it)
+        remote_socket.setSocketOption(QAbstractSocket::SocketOption(it.key()), it.value());
+#ifndef QT_NO_SSL
+    if (ssl_active) {
+        remote_socket.startClientEncryption();
+        return;
+    }
+#endif
+    processRemoteSocketConnected();
+#else
+    Q_UNUSED(sd);
+    Q_ASSERT(false);
+#endif
 }
 
 void RemoteDBusConnectionTunnel::closeChannel()
 {
-    switch (remote_socket.state()) {
+    switch (remoteSocketState()) {
     case QAbstractSocket::UnconnectedState:
         Q_EMIT channelClosed(false);
         break;
@@ -166,7 +1060,7 @@ void RemoteDBusConnectionTunnel::closeChannel()
 
 void RemoteDBusConnectionTunnel::abortChannel()
 {
-    switch (remote_socket.state()) {
+    switch (remoteSocketState()) {
     case QAbstractSocket::UnconnectedState:
     case QAbstractSocket::ClosingState:
         break;
@@ -184,9 +1078,43 @@ void RemoteDBusConnectionTunnel::abortChannel()
 
 void RemoteDBusConnectionTunnel::setRemoteSocketOption(QAbstractSocket::SocketOption option, const QVariant &value)
 {
+    remote_socket_options.insert(int(option), value);
     remote_socket.setSocketOption(option, value);
 }
 
+void RemoteDBusConnectionTunnel::applySocketBufferSizes(QIODevice *socket)
+{
+    mutex.lock();
+    int send_size = socket_send_buffer_size;
+    int receive_size = socket_receive_buffer_size;
+    mutex.unlock();
+    if ((send_size == 0) && (receive_size == 0))
+        return;
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket)) {
+        if (send_size > 0)
+            abstract_socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, send_size);
+        if (receive_size > 0)
+            abstract_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, receive_size);
+        return;
+    }
+#ifdef Q_OS_LINUX
+    // QLocalSocket has no socket options API
+    qintptr sd = socketDescriptor(socket);
+    if (sd == -1)
+        return;
+    bool success = true;
+    if (send_size > 0)
+        success &= (setsockopt(sd, SOL_SOCKET, SO_SNDBUF, &send_size, sizeof(send_size)) == 0);
+    if (receive_size > 0)
+        success &= (setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &receive_size, sizeof(receive_size)) == 0);
+    if (!success) {
+        char error_buf[255];
+        Q_EMIT channelError(QString("Failed to set buffer sizes for local socket with error: %1 (%2)")
+                            .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
+    }
+#endif
+}
+
 #ifdef Q_OS_LINUX
 void RemoteDBusConnectionTunnel::applyRemoteSocketKeepaliveParams()
 {
@@ -217,29 +1145,148 @@ void RemoteDBusConnectionTunnel::applyRemoteSocketKeepaliveParams()
                             .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
     }
 }
-#endif
 
-void RemoteDBusConnectionTunnel::startConnectionTimer()
+void RemoteDBusConnectionTunnel::applyRemoteSocketCongestionControl()
 {
-    QMutexLocker locker(&mutex);
-    if (connection_timeout_ms != -1)
-        connection_timer.start(connection_timeout_ms);
+    mutex.lock();
+    QByteArray algorithm = congestion_control;
+    mutex.unlock();
+    if (algorithm.isEmpty())
+        return;
+    qintptr sd = remote_socket.socketDescriptor();
+    if (sd == -1)
+        return;
+    if (setsockopt(sd, SOL_TCP, TCP_CONGESTION, algorithm.constData(), socklen_t(algorithm.size())) != 0) {
+        char error_buf[255];
+        Q_EMIT channelError(QString("Failed to set congestion control \"%1\" for remote socket with error: %2 (%3)")
+                            .arg(QString::fromLatin1(algorithm))
+                            .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
+    }
 }
 
-void RemoteDBusConnectionTunnel::processRemoteSocketConnected()
+// Kernel leaves quick ack mode on its own, so it's requested again after every read
+void RemoteDBusConnectionTunnel::rearmRemoteSocketQuickAck()
 {
-    connection_timer.stop();
+    if (!tcp_quickack_enabled.load())
+        return;
+    qintptr sd = remote_socket.socketDescriptor();
+    if (sd == -1)
+        return;
+    int optval = 1;
+    if (setsockopt(sd, SOL_TCP, TCP_QUICKACK, &optval, sizeof(optval)) != 0) {
+        // Don't flood with same error at every read
+        tcp_quickack_enabled.store(0);
+        char error_buf[255];
+        Q_EMIT channelError(QString("Failed to set quick ack option for remote socket with error: %1 (%2)")
+                            .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
+    }
+}
+
+// Used to coalesce burst of outgoing data into as few segments as possible
+// Calls nest (batches may be sent concurrently), so socket stays corked until last of them uncorks it
+void RemoteDBusConnectionTunnel::setRemoteSocketCorked(bool corked)
+{
+    if (corked) {
+        if (remote_socket_cork_depth++ > 0)
+            return;
+    } else {
+        if ((remote_socket_cork_depth == 0) || (--remote_socket_cork_depth > 0))
+            return;
+    }
+    qintptr sd = remote_socket.socketDescriptor();
+    if (sd == -1)
+        return;
+    if (!corked && (local_socket != nullptr)) {
+        // Push already received data before releasing cork
+        if (!splice_relay_active)
+            transferDataFromSocketToSocket(local_socket, &remote_socket);
+        remote_socket.flush();
+    }
+    int optval = corked ? 1 : 0;
+    if (setsockopt(sd, SOL_TCP, TCP_CORK, &optval, sizeof(optval)) != 0) {
+        char error_buf[255];
+        Q_EMIT channelError(QString("Failed to set cork option for remote socket with error: %1 (%2)")
+                            .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
+    }
+}
+#endif
+
+void RemoteDBusConnectionTunnel::startConnectionTimer()
+{
+    QMutexLocker locker(&mutex);
+    if (connection_timeout_ms != -1)
+        connection_timer.start(connection_timeout_ms);
+}
+
+void RemoteDBusConnectionTunnel::processRemoteSocketConnected()
+{
+#ifndef QT_NO_SSL
+    // Tunnel starts after handshake completed (signalled with encrypted())
+    if (ssl_active) {
+        if (!remote_socket.isEncrypted())
+            return;
+        storeSslSessionTicket();
+    }
+#endif
+    bool connect_confirmed = true;
+#ifdef Q_OS_LINUX
+    connect_confirmed = !fast_open_connect_pending;
+#endif
+    if (connect_confirmed) {
+        connection_timer.stop();
+        statistics.last_connect_duration_us.store(connect_clock.nsecsElapsed() / 1000);
+    }
 #ifdef Q_OS_LINUX
     applyRemoteSocketKeepaliveParams();
+    applyRemoteSocketCongestionControl();
 #endif
+    applySocketBufferSizes(&remote_socket);
+    remote_socket.setReadBufferSize(active_relay_high_watermark);
+    updateWrappedOperationWatchdog();
+
+    if (channel_opened_early) {
+        channel_opened_early = false;
+        if (local_socket != nullptr)
+            startLocalRelay();
+        return;
+    }
+    Q_ASSERT(!local_address.isEmpty());
+    Q_EMIT channelOpened(true, local_address);
+}
 
-    Q_ASSERT(local_server.isListening());
-    Q_EMIT channelOpened(true, local_server.serverPort());
+// Settings taken at start of every connection
+void RemoteDBusConnectionTunnel::activateRelaySettings()
+{
+    mutex.lock();
+    active_relay_high_watermark = relay_high_watermark;
+    active_relay_low_watermark = relay_low_watermark;
+    active_relay_chunk_size = (relay_chunk_size > 0) ? relay_chunk_size : relay_default_chunk_size;
+    compression_active = compression_enabled;
+    frame_encoder = RelayFrameEncoder(compression_level);
+    mutex.unlock();
+    frame_decoder.reset();
+    remote_to_local_paused = false;
+    local_to_remote_paused = false;
+#ifdef Q_OS_LINUX
+    // New socket isn't corked, batches sent over previous one are over
+    remote_socket_cork_depth = 0;
+#endif
+    // Kept allocated for next connections, unless chunk size changes
+    remote_to_local_buffer.resize(active_relay_chunk_size);
+    local_to_remote_buffer.resize(active_relay_chunk_size);
 }
 
 void RemoteDBusConnectionTunnel::processRemoteSocketDisconnected()
 {
+#ifndef QT_NO_SSL
+    if (ssl_active)
+        storeSslSessionTicket();
+#endif
+#ifdef Q_OS_LINUX
+    fast_open_connect_pending = false;
+#endif
     connection_timer.stop();
+    wrapped_operation_watchdog.stop();
 
     stopLocalServer();
     Q_EMIT channelClosed(true);
@@ -248,9 +1295,45 @@ void RemoteDBusConnectionTunnel::processRemoteSocketDisconnected()
 void RemoteDBusConnectionTunnel::processRemoteSocketError()
 {
     Q_EMIT channelError(QString("Remote connection error: %1").arg(remote_socket.errorString()));
+#ifndef QT_NO_SSL
+    if (isSslHandshakeInProgress()) {
+        // Handshake failed, it's still part of connect attempt
+        ssl_session_ticket.clear();
+        disconnectRemoteSocket(false);
+        stopLocalServer();
+        failChannelOpening();
+        return;
+    }
+#endif
+    if (remote_socket.state() == QAbstractSocket::ConnectedState) {
+        // Established connection broke (or fast open one failed at first write), disconnected() follows
+        return;
+    }
     processConnectionFailure(true);
 }
 
+#ifndef QT_NO_SSL
+void RemoteDBusConnectionTunnel::processRemoteSocketSslErrors(const QList<QSslError> &errors)
+{
+    // Unless ignored by configuration, handshake fails with error signalled afterwards
+    for (const QSslError &error : errors)
+        Q_EMIT channelError(QString("Remote connection SSL error: %1").arg(error.errorString()));
+}
+
+// Ticket may be issued at handshake (TLS 1.2) or any time after it (TLS 1.3), previous one is kept otherwise
+void RemoteDBusConnectionTunnel::storeSslSessionTicket()
+{
+    QByteArray ticket = remote_socket.sslConfiguration().sessionTicket();
+    if (!ticket.isEmpty())
+        ssl_session_ticket = ticket;
+}
+
+bool RemoteDBusConnectionTunnel::isSslHandshakeInProgress() const
+{
+    return (ssl_active && !remote_socket.isEncrypted() && (remote_socket.state() == QAbstractSocket::ConnectedState));
+}
+#endif
+
 void RemoteDBusConnectionTunnel::processConnectionTimeout()
 {
     processConnectionFailure(false);
@@ -258,14 +1341,37 @@ void RemoteDBusConnectionTunnel::processConnectionTimeout()
 
 void RemoteDBusConnectionTunnel::processConnectionFailure(bool socket_error)
 {
-    switch (remote_socket.state()) {
+#ifndef QT_NO_SSL
+    if (isSslHandshakeInProgress()) {
+        // Stalled handshake, it's still part of connect attempt
+        ssl_session_ticket.clear();
+        disconnectRemoteSocket(false);
+        stopLocalServer();
+        if (!socket_error)
+            Q_EMIT channelError("Remote connect attempt timed out during TLS handshake");
+        failChannelOpening();
+        return;
+    }
+#endif
+#ifdef Q_OS_LINUX
+    if (fast_open_connect_pending) {
+        // Channel is already opened, so unconfirmed connection is closed same way as broken one
+        disconnectRemoteSocket(false);
+        stopLocalServer();
+        if (!socket_error)
+            Q_EMIT channelError("Remote connect attempt timed out waiting for first reply");
+        Q_EMIT channelClosed(true);
+        return;
+    }
+#endif
+    switch (remoteSocketState()) {
     case QAbstractSocket::HostLookupState:
     case QAbstractSocket::ConnectingState:
         disconnectRemoteSocket(false);
         stopLocalServer();
         if (!socket_error)
             Q_EMIT channelError("Remote connect attempt timed out");
-        Q_EMIT channelOpened(false);
+        failChannelOpening();
         break;
     case QAbstractSocket::ClosingState:
         disconnectRemoteSocket(false);
@@ -285,7 +1391,16 @@ void RemoteDBusConnectionTunnel::processConnectionFailure(bool socket_error)
 
 void RemoteDBusConnectionTunnel::disconnectRemoteSocket(bool graceful)
 {
+    stopConnectionRace();
+#ifdef Q_OS_LINUX
+    stopFastOpenConnect();
+    fast_open_connect_pending = false;
+#endif
     connection_timer.stop();
+    wrapped_operation_watchdog.stop();
+#ifdef Q_OS_LINUX
+    stopSpliceRelay();
+#endif
     if (graceful) {
         remote_socket.disconnectFromHost();
         if (remote_socket.state() != QAbstractSocket::UnconnectedState)
@@ -299,9 +1414,45 @@ void RemoteDBusConnectionTunnel::disconnectRemoteSocket(bool graceful)
 
 bool RemoteDBusConnectionTunnel::startLocalServer()
 {
+    mutex.lock();
+    active_local_transport = local_transport;
+    mutex.unlock();
+    local_address.clear();
+
+    if (active_local_transport == RemoteDBusConnection::LocalUnixSocketTransport) {
+        QString server_name = QString("qtextra-remotedbus-%1-%2")
+                .arg(QCoreApplication::applicationPid()).arg(quintptr(this), 0, 16);
+#if defined(Q_OS_LINUX) && (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+        // Abstract namespace socket doesn't occupy any file system entry (adopted with QLocalServer::listen(qintptr))
+        int sd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (sd == -1)
+            return false;
+        QByteArray abstract_name = server_name.toLatin1();
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path + 1, abstract_name.constData(), abstract_name.size());
+        socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + 1 + abstract_name.size();
+        if ((::bind(sd, reinterpret_cast<struct sockaddr *>(&addr), addr_len) != 0) ||
+            (::listen(sd, 1) != 0) || !local_unix_server.listen(sd)) {
+            ::close(sd);
+            return false;
+        }
+        local_address = "unix:abstract=" + server_name;
+#else
+        QLocalServer::removeServer(server_name);
+        if (!local_unix_server.listen(server_name))
+            return false;
+        local_address = "unix:path=" + escapeDBusAddressValue(local_unix_server.fullServerName());
+#endif
+        return true;
+    }
+
     bool result = local_server.listen(QHostAddress::LocalHost);
-    if (result)
+    if (result) {
         local_server.resumeAccepting();
+        local_address = QString("tcp:host=localhost,port=%1").arg(local_server.serverPort());
+    }
     return result;
 }
 
@@ -309,9 +1460,14 @@ void RemoteDBusConnectionTunnel::stopLocalServer()
 {
     if (local_server.isListening())
         local_server.close();
+    if (local_unix_server.isListening())
+        local_unix_server.close();
+#ifdef Q_OS_LINUX
+    stopSpliceRelay();
+#endif
     if (local_socket) {
         local_socket->blockSignals(true);
-        local_socket->abort();
+        abortSocket(local_socket);
         local_socket->deleteLater();
         local_socket = nullptr;
     }
@@ -321,264 +1477,1584 @@ void RemoteDBusConnectionTunnel::processLocalServerNewConnection()
 {
     local_server.pauseAccepting();
     Q_ASSERT(local_socket == nullptr);
-    local_socket = local_server.nextPendingConnection();
-    QObject::connect(local_socket, &QTcpSocket::readyRead,
+    setupLocalSocket(local_server.nextPendingConnection());
+}
+
+void RemoteDBusConnectionTunnel::processLocalUnixServerNewConnection()
+{
+    QLocalSocket *socket = local_unix_server.nextPendingConnection();
+    if (local_socket != nullptr) {
+        // Only single connection expected from QDBusConnection
+        socket->abort();
+        socket->deleteLater();
+        return;
+    }
+    // Stop listening right away, so nobody else can connect and name is released
+    local_unix_server.close();
+    setupLocalSocket(socket);
+}
+
+void RemoteDBusConnectionTunnel::setupLocalSocket(QIODevice *socket)
+{
+    local_socket = socket;
+    QObject::connect(local_socket, &QIODevice::readyRead,
                      this, &RemoteDBusConnectionTunnel::processLocalSocketReadyRead);
+    QObject::connect(local_socket, &QIODevice::bytesWritten,
+                     this, &RemoteDBusConnectionTunnel::processLocalSocketBytesWritten);
+    setSocketReadBufferSize(local_socket, active_relay_high_watermark);
+    applySocketBufferSizes(local_socket);
+    // Otherwise data is held in local socket until remote one connects (see processRemoteSocketConnected())
+    if (!channel_opened_early)
+        startLocalRelay();
+}
+
+void RemoteDBusConnectionTunnel::startLocalRelay()
+{
+#ifdef Q_OS_LINUX
+    mutex.lock();
+    bool use_splice_relay = splice_relay_enabled;
+    mutex.unlock();
+    // Compressed or encrypted stream must pass through user space
+    bool user_space_relay = compression_active;
+#ifndef QT_NO_SSL
+    user_space_relay |= ssl_active;
+#endif
+    if (use_splice_relay && user_space_relay)
+        Q_EMIT channelError("Zero-copy relay isn't compatible with compression and TLS, using regular one");
+    else if (use_splice_relay && !startSpliceRelay())
+        Q_EMIT channelError("Failed to start zero-copy relay, falling back to regular one");
+    if (splice_relay_active)
+        return;
+#endif
+    // Data may be received while remote socket was connecting
+    transferDataFromSocketToSocket(local_socket, &remote_socket);
 }
 
 void RemoteDBusConnectionTunnel::processRemoteSocketReadyRead()
 {
+#ifdef Q_OS_LINUX
+    confirmFastOpenConnect();
+#endif
     if (local_socket == nullptr)
         return;
+#ifdef Q_OS_LINUX
+    if (splice_relay_active) {
+        transferDataBySplice(&remote_to_local_relay);
+        rearmRemoteSocketQuickAck();
+        return;
+    }
+#endif
     transferDataFromSocketToSocket(&remote_socket, local_socket);
+#ifdef Q_OS_LINUX
+    rearmRemoteSocketQuickAck();
+#endif
 }
 
 void RemoteDBusConnectionTunnel::processLocalSocketReadyRead()
 {
-    if (local_socket == nullptr)
+    if ((local_socket == nullptr) || channel_opened_early)
+        return;
+#ifdef Q_OS_LINUX
+    if (splice_relay_active) {
+        transferDataBySplice(&local_to_remote_relay);
         return;
+    }
+#endif
     transferDataFromSocketToSocket(local_socket, &remote_socket);
 }
 
-void RemoteDBusConnectionTunnel::transferDataFromSocketToSocket(QTcpSocket *src_socket, QTcpSocket *dest_socket)
+void RemoteDBusConnectionTunnel::processRemoteSocketBytesWritten()
 {
-    QByteArray data = src_socket->readAll();
-    if (data.isEmpty())
+    if ((local_socket == nullptr) || !local_to_remote_paused)
+        return;
+    if (remote_socket.bytesToWrite() > active_relay_low_watermark)
         return;
-    qint64 written Q_DECL_UNUSED;
-    written = dest_socket->write(data);
-    Q_ASSERT((written < 0) || (written == data.size()));
+    local_to_remote_paused = false;
+    transferDataFromSocketToSocket(local_socket, &remote_socket);
 }
 
-void RemoteDBusConnectionTunnel::syncStartWrappedOperation()
+void RemoteDBusConnectionTunnel::processLocalSocketBytesWritten()
 {
-    wrapped_operation_timed_out = false;
-    wrapped_operation_semaphore.acquire();
-    if (wrapped_operation_timeout_ms != -1)
-        wrapped_operation_timer.start(wrapped_operation_timeout_ms);
+    if ((local_socket == nullptr) || !remote_to_local_paused)
+        return;
+    if (local_socket->bytesToWrite() > active_relay_low_watermark)
+        return;
+    remote_to_local_paused = false;
+    transferDataFromSocketToSocket(&remote_socket, local_socket);
 }
 
-void RemoteDBusConnectionTunnel::asyncStopWrappedOperation()
+void RemoteDBusConnectionTunnel::transferDataFromSocketToSocket(QIODevice *src_socket, QIODevice *dest_socket)
 {
-    if (wrapped_operation_timeout_ms != -1)
-        QTMETAMETHOD_INVOKE_QUEUED(&wrapped_operation_timer, stop);
-    wrapped_operation_semaphore.release();
+    const bool &paused = (src_socket == &remote_socket) ? remote_to_local_paused : local_to_remote_paused;
+    QTEXTRA_TRACE2(relay_begin, this, int(src_socket != &remote_socket));
+    qint64 relayed_size = 0;
+    do {
+        relayed_size += transferDataChunk(src_socket, dest_socket);
+    } while (!paused && (remote_socket.state() == QAbstractSocket::ConnectedState) &&
+             (src_socket->bytesAvailable() > 0));
+    QTEXTRA_TRACE3(relay_end, this, int(src_socket != &remote_socket), relayed_size);
 }
 
-bool RemoteDBusConnectionTunnel::isWrappedOperationTimedOut()
+// Data passes through preallocated buffer of direction, so relay doesn't allocate in steady state
+// (only compression allocates, since its frames are built in new arrays)
+qint64 RemoteDBusConnectionTunnel::transferDataChunk(QIODevice *src_socket, QIODevice *dest_socket)
 {
-    return wrapped_operation_timed_out;
+    QByteArray &buffer = (src_socket == &remote_socket) ? remote_to_local_buffer : local_to_remote_buffer;
+    bool &paused = (src_socket == &remote_socket) ? remote_to_local_paused : local_to_remote_paused;
+    Q_ASSERT(buffer.size() == active_relay_chunk_size);
+    qint64 read_size = active_relay_chunk_size;
+    bool limited_by_watermark = false;
+    if (active_relay_high_watermark > 0) {
+        if (paused)
+            return 0;
+        qint64 free_space = active_relay_high_watermark - dest_socket->bytesToWrite();
+        if (free_space <= 0) {
+            // Leave data in source socket, it stops reading at its buffer limit
+            paused = true;
+            return 0;
+        }
+        limited_by_watermark = (free_space <= read_size);
+        read_size = qMin(free_space, read_size);
+    }
+    qint64 read = src_socket->read(buffer.data(), read_size);
+    if (read <= 0)
+        return 0;
+    if (limited_by_watermark && (src_socket->bytesAvailable() > 0))
+        paused = true; // the rest waits until destination drains
+    // Counted as D-Bus stream bytes, regardless of compression
+    qint64 relayed_size = read;
+    qint64 written;
+    qint64 write_size = read;
+    if (compression_active) {
+        QByteArray data = QByteArray::fromRawData(buffer.constData(), int(read));
+        if (src_socket == &remote_socket) {
+            QByteArray decoded;
+            if (!frame_decoder.decode(data, &decoded)) {
+                Q_EMIT channelError("Corrupted compressed stream received from remote side, aborting");
+                remote_socket.abort();
+                return 0;
+            }
+            data = decoded;
+            relayed_size = data.size();
+            if (data.isEmpty())
+                return 0; // incomplete frame
+        } else {
+            data = frame_encoder.encode(data);
+        }
+        write_size = data.size();
+        written = dest_socket->write(data);
+    } else {
+        written = dest_socket->write(buffer.constData(), read);
+    }
+    Q_ASSERT((written < 0) || (written == write_size));
+    Q_UNUSED(write_size);
+    if (written > 0) {
+        QAtomicInteger<quint64> &bytes_counter = (src_socket == &remote_socket) ?
+                    statistics.bytes_remote_to_local : statistics.bytes_local_to_remote;
+        bytes_counter.fetchAndAddRelaxed(quint64(relayed_size));
+        return relayed_size;
+    }
+    return 0;
 }
 
-void RemoteDBusConnectionTunnel::processWrappedOperationTimeout()
+#ifdef Q_OS_LINUX
+bool RemoteDBusConnectionTunnel::startSpliceRelay()
 {
-    wrapped_operation_timed_out = true;
-    if (remote_socket.state() != QAbstractSocket::ConnectedState)
-        return;
-    abortChannel();
-    wrapped_operation_semaphore.acquire();
-    wrapped_operation_semaphore.release();
-    Q_EMIT channelClosed(true);
-}
+    Q_ASSERT(!splice_relay_active);
+    Q_ASSERT(local_socket != nullptr);
 
-RemoteDBusConnection::RemoteDBusConnection(const QString &name, QObject *parent) :
-    QObject(parent),
-    ref(nullptr), ref_name(name),
-    tunnel_thread(this)
-{
-    qRegisterMetaType<QAbstractSocket::NetworkLayerProtocol>();
+    // Move out data already buffered by sockets, because relay bypasses their buffers
+    transferDataFromSocketToSocket(&remote_socket, local_socket);
+    transferDataFromSocketToSocket(local_socket, &remote_socket);
+    remote_socket.flush();
+    flushSocket(local_socket);
+    if ((remote_socket.bytesAvailable() > 0) || (local_socket->bytesAvailable() > 0) ||
+        (remote_socket.bytesToWrite() > 0) || (local_socket->bytesToWrite() > 0))
+        return false;
 
-    tunnel = new RemoteDBusConnectionTunnel();
-    Q_CHECK_PTR(tunnel);
-    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelOpened,
-                     this, &RemoteDBusConnection::processTunnelChannelOpened);
-    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelClosed,
-                     this, &RemoteDBusConnection::processTunnelChannelClosed);
-    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelError,
-                     this, &RemoteDBusConnection::connectionError);
+    // Relay notifiers watch own descriptors, so they don't share ones watched by Qt sockets
+    int remote_fd = ::fcntl(int(remote_socket.socketDescriptor()), F_DUPFD_CLOEXEC, 0);
+    int local_fd = ::fcntl(int(socketDescriptor(local_socket)), F_DUPFD_CLOEXEC, 0);
+    if ((remote_fd == -1) || (local_fd == -1)) {
+        if (remote_fd != -1)
+            ::close(remote_fd);
+        if (local_fd != -1)
+            ::close(local_fd);
+        return false;
+    }
+    SpliceRelay *relays[2] = { &remote_to_local_relay, &local_to_remote_relay };
+    remote_to_local_relay.src_socket = &remote_socket;
+    remote_to_local_relay.src_fd = remote_fd;
+    remote_to_local_relay.dest_fd = local_fd;
+    local_to_remote_relay.src_socket = local_socket;
+    local_to_remote_relay.src_fd = local_fd;
+    local_to_remote_relay.dest_fd = remote_fd;
+    for (int i = 0; i < 2; i++) {
+        relays[i]->pipe_size = 0;
+        relays[i]->src_notifier = nullptr;
+        relays[i]->dest_notifier = nullptr;
+        if (pipe2(relays[i]->pipe_fds, O_NONBLOCK | O_CLOEXEC) != 0) {
+            if (i > 0) {
+                ::close(relays[0]->pipe_fds[0]);
+                ::close(relays[0]->pipe_fds[1]);
+            }
+            ::close(remote_fd);
+            ::close(local_fd);
+            return false;
+        }
+        // Larger chunk needs larger pipe, failure (limited by fs.pipe-max-size) only means smaller moves
+        if (active_relay_chunk_size > relay_default_chunk_size)
+            fcntl(relays[i]->pipe_fds[1], F_SETPIPE_SZ, active_relay_chunk_size);
+    }
 
-    tunnel->moveToThread(&tunnel_thread);
-    QObject::connect(&tunnel_thread, &QThread::finished,
-                     tunnel, &RemoteDBusConnectionTunnel::deleteLater);
-    tunnel_thread.start();
+    // Qt sockets stop reading once their buffers are full, so they take single byte at most while relay is active
+    // (such byte is passed through relay pipe ahead of data still queued in kernel, see transferDataBySplice())
+    remote_socket.setReadBufferSize(1);
+    setSocketReadBufferSize(local_socket, 1);
+    splice_remote_fd = remote_fd;
+    splice_local_fd = local_fd;
+
+    remote_to_local_relay.src_notifier = new QSocketNotifier(remote_fd, QSocketNotifier::Read, this);
+    remote_to_local_relay.dest_notifier = new QSocketNotifier(local_fd, QSocketNotifier::Write, this);
+    local_to_remote_relay.src_notifier = new QSocketNotifier(local_fd, QSocketNotifier::Read, this);
+    local_to_remote_relay.dest_notifier = new QSocketNotifier(remote_fd, QSocketNotifier::Write, this);
+    remote_to_local_relay.dest_notifier->setEnabled(false);
+    local_to_remote_relay.dest_notifier->setEnabled(false);
+    QObject::connect(remote_to_local_relay.src_notifier, &QSocketNotifier::activated,
+                     this, &RemoteDBusConnectionTunnel::processRemoteSocketSpliceReadable);
+    QObject::connect(remote_to_local_relay.dest_notifier, &QSocketNotifier::activated,
+                     this, &RemoteDBusConnectionTunnel::processLocalSocketSpliceWritable);
+    QObject::connect(local_to_remote_relay.src_notifier, &QSocketNotifier::activated,
+                     this, &RemoteDBusConnectionTunnel::processLocalSocketSpliceReadable);
+    QObject::connect(local_to_remote_relay.dest_notifier, &QSocketNotifier::activated,
+                     this, &RemoteDBusConnectionTunnel::processRemoteSocketSpliceWritable);
+
+    splice_relay_active = true;
+    return true;
 }
 
-RemoteDBusConnection::~RemoteDBusConnection()
+void RemoteDBusConnectionTunnel::stopSpliceRelay()
 {
-    if (isConnectionOpened()) {
-        dropNativeDBusConnection();
-        QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
+    if (!splice_relay_active)
+        return;
+    splice_relay_active = false;
+    SpliceRelay *relays[2] = { &remote_to_local_relay, &local_to_remote_relay };
+    for (int i = 0; i < 2; i++) {
+        // Notifiers may be stopped from their own activation handler
+        relays[i]->src_notifier->setEnabled(false);
+        relays[i]->src_notifier->deleteLater();
+        relays[i]->dest_notifier->setEnabled(false);
+        relays[i]->dest_notifier->deleteLater();
+        relays[i]->src_notifier = nullptr;
+        relays[i]->dest_notifier = nullptr;
+        ::close(relays[i]->pipe_fds[0]);
+        ::close(relays[i]->pipe_fds[1]);
     }
-    tunnel_thread.quit();
-    tunnel_thread.wait();
-    Q_ASSERT(tunnel_thread.isFinished());
+    ::close(splice_remote_fd);
+    ::close(splice_local_fd);
+    splice_remote_fd = -1;
+    splice_local_fd = -1;
+    // Qt sockets resume reading (and detect end of stream, if any)
+    remote_socket.setReadBufferSize(active_relay_high_watermark);
+    if (local_socket != nullptr)
+        setSocketReadBufferSize(local_socket, active_relay_high_watermark);
 }
 
-void RemoteDBusConnection::setConnectionTimeout(int timeout_ms)
+void RemoteDBusConnectionTunnel::processRemoteSocketSpliceReadable()
 {
-    QMutexLocker locker(&tunnel->mutex);
-    tunnel->connection_timeout_ms = timeout_ms;
+    confirmFastOpenConnect();
+    transferDataBySplice(&remote_to_local_relay);
+    rearmRemoteSocketQuickAck();
 }
 
-void RemoteDBusConnection::setWrappedOperationTimeout(int timeout_ms)
+void RemoteDBusConnectionTunnel::processRemoteSocketSpliceWritable()
 {
-    tunnel->wrapped_operation_timeout_ms = timeout_ms;
+    transferDataBySplice(&local_to_remote_relay);
 }
 
-bool RemoteDBusConnection::setKeepaliveEnabled(bool enabled)
+void RemoteDBusConnectionTunnel::processLocalSocketSpliceReadable()
 {
-#ifdef Q_OS_WIN
-    if (isConnectionOpened())
-        return false;
-#endif
-    QTMETAMETHOD_INVOKE_ARGS2(tunnel, setRemoteSocketOption, Qt::BlockingQueuedConnection,
-                                     (QAbstractSocket::SocketOption, QAbstractSocket::KeepAliveOption),
-                                     (const QVariant&, QVariant((int)enabled)));
-    return true;
+    transferDataBySplice(&local_to_remote_relay);
 }
 
-void RemoteDBusConnection::setLowDelayOption(bool enabled)
+void RemoteDBusConnectionTunnel::processLocalSocketSpliceWritable()
 {
-    QTMETAMETHOD_INVOKE_ARGS2(tunnel, setRemoteSocketOption, Qt::BlockingQueuedConnection,
-                                     (QAbstractSocket::SocketOption, QAbstractSocket::LowDelayOption),
-                                     (const QVariant&, QVariant((int)enabled)));
+    transferDataBySplice(&remote_to_local_relay);
 }
 
-#ifdef Q_OS_LINUX
-void RemoteDBusConnection::setKeepaliveParameters(int keepcnt, int keepidle, int keepintvl)
+void RemoteDBusConnectionTunnel::transferDataBySplice(SpliceRelay *relay)
 {
-    tunnel->mutex.lock();
-    tunnel->keepalive_params.active = true;
-    tunnel->keepalive_params.keepcnt = keepcnt;
-    tunnel->keepalive_params.keepidle = keepidle;
-    tunnel->keepalive_params.keepintvl = keepintvl;
-    tunnel->mutex.unlock();
-    if (isConnectionOpened())
-        QTMETAMETHOD_INVOKE(tunnel, applyRemoteSocketKeepaliveParams, Qt::BlockingQueuedConnection);
+    bool stream_end = false;
+    for (int round = 0; (round < splice_relay_max_rounds) && !stream_end; round++) {
+        ssize_t moved;
+        if (relay->pipe_size > 0) {
+            moved = splice(relay->pipe_fds[0], nullptr, relay->dest_fd, nullptr,
+                           relay->pipe_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (moved > 0) {
+                relay->pipe_size -= moved;
+                QTEXTRA_TRACE3(relay_splice, this, int(relay == &local_to_remote_relay), qint64(moved));
+                QAtomicInteger<quint64> &bytes_counter = (relay == &remote_to_local_relay) ?
+                            statistics.bytes_remote_to_local : statistics.bytes_local_to_remote;
+                bytes_counter.fetchAndAddRelaxed(quint64(moved));
+                continue;
+            }
+            if ((moved < 0) && (errno == EINTR))
+                continue;
+            if ((moved < 0) && (errno == EAGAIN)) {
+                // Destination is full, wait until it drains
+                relay->src_notifier->setEnabled(false);
+                relay->dest_notifier->setEnabled(true);
+                return;
+            }
+            stream_end = true;
+        } else {
+            relay->dest_notifier->setEnabled(false);
+            relay->src_notifier->setEnabled(true);
+            if (relay->src_socket->bytesAvailable() > 0) {
+                // Read by Qt socket before data still queued in kernel, so it goes first (pipe is empty here)
+                QByteArray buffered = relay->src_socket->readAll();
+                moved = ::write(relay->pipe_fds[1], buffered.constData(), size_t(buffered.size()));
+                if (moved > 0)
+                    relay->pipe_size += moved;
+                if (moved == buffered.size())
+                    continue;
+                stream_end = true;
+                break;
+            }
+            moved = splice(relay->src_fd, nullptr, relay->pipe_fds[1], nullptr,
+                           active_relay_chunk_size, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (moved > 0) {
+                relay->pipe_size += moved;
+                continue;
+            }
+            if ((moved < 0) && (errno == EINTR))
+                continue;
+            if ((moved < 0) && (errno == EAGAIN))
+                return;
+            stream_end = true;
+        }
+    }
+    if (!stream_end) {
+        // Rounds limit reached, continue in next event loop cycle
+        if (relay->pipe_size > 0) {
+            relay->src_notifier->setEnabled(false);
+            relay->dest_notifier->setEnabled(true);
+        }
+        return;
+    }
+    // End of stream or error, let Qt sockets detect and handle it in regular way
+    stopSpliceRelay();
 }
+#endif
 
-void RemoteDBusConnection::unsetKeepaliveParameters()
+// Called from wrapped operation thread
+// Returns slot occupied by operation, or -1 if no slot freed within timeout_ms (negative value - without limit)
+int RemoteDBusConnectionTunnel::startWrappedOperation(int timeout_ms)
 {
-    tunnel->mutex.lock();
-    tunnel->keepalive_params.active = false;
-    tunnel->mutex.unlock();
+    int slot = occupyWrappedOperationSlot(wrapped_operation_clock.elapsed());
+    if (slot != -1)
+        return slot;
+    // All slots are busy, wait until any of operations finishes
+    qint64 wait_start_ns = wrapped_operation_clock.nsecsElapsed();
+    QElapsedTimer wait_clock;
+    wait_clock.start();
+    wrapped_operation_waiters.fetchAndAddOrdered(1);
+    wrapped_operation_mutex.lock();
+    forever {
+        slot = occupyWrappedOperationSlot(wrapped_operation_clock.elapsed());
+        if (slot != -1)
+            break;
+        if (timeout_ms < 0) {
+            wrapped_operation_finished.wait(&wrapped_operation_mutex);
+            continue;
+        }
+        qint64 remaining_ms = timeout_ms - wait_clock.elapsed();
+        if (remaining_ms <= 0)
+            break;
+        wrapped_operation_finished.wait(&wrapped_operation_mutex, ulong(remaining_ms));
+    }
+    wrapped_operation_mutex.unlock();
+    wrapped_operation_waiters.fetchAndAddOrdered(-1);
+    statistics.wrapped_operation_slot_waits.fetchAndAddRelaxed(1);
+    statistics.wrapped_operation_slot_wait_us.fetchAndAddRelaxed((wrapped_operation_clock.nsecsElapsed() - wait_start_ns) / 1000);
+    return slot;
 }
-#endif
 
-bool RemoteDBusConnection::isConnectionOpened() const
+int RemoteDBusConnectionTunnel::occupyWrappedOperationSlot(qint64 start_ms)
 {
-    return (ref != nullptr);
+    for (int i = 0; i < wrapped_operation_slot_count; i++) {
+        if (wrapped_operation_slots[i].testAndSetOrdered(wrapped_operation_idle, start_ms)) {
+            QTEXTRA_TRACE2(wrapped_operation_start, this, i);
+            return i;
+        }
+    }
+    return -1;
 }
 
-bool RemoteDBusConnection::openConnection(const QString &hostname, quint16 port, QAbstractSocket::NetworkLayerProtocol protocol)
+// Called from wrapped operation thread
+// Returns false if operation timed out
+bool RemoteDBusConnectionTunnel::stopWrappedOperation(int slot)
 {
-    if (isConnectionOpened())
-        return false;
-    QTMETAMETHOD_INVOKE_QUEUED_ARGS3(tunnel, openChannel, (const QString&, hostname), (quint16, port), (QAbstractSocket::NetworkLayerProtocol, protocol));
-    return true;
+    qint64 start_ms = wrapped_operation_slots[slot].fetchAndStoreOrdered(wrapped_operation_idle);
+    QTEXTRA_TRACE3(wrapped_operation_stop, this, slot, int(start_ms == wrapped_operation_timed_out));
+    // Waiters are counted before they check slots, so either they see freed slot, or they are woken
+    if (wrapped_operation_waiters.loadAcquire() > 0) {
+        QMutexLocker locker(&wrapped_operation_mutex);
+        wrapped_operation_finished.wakeAll();
+    }
+    return (start_ms != wrapped_operation_timed_out);
 }
 
-bool RemoteDBusConnection::closeConnection()
+// Called from asynchronous call thread
+// Waits for place in calls window (up to timeout_ms, negative value - without limit) and reserves it
+bool RemoteDBusConnectionTunnel::reserveAsyncCall(int window, int timeout_ms)
 {
-    if (!isConnectionOpened())
-        return false;
-    dropNativeDBusConnection();
-    QTMETAMETHOD_INVOKE_QUEUED(tunnel, closeChannel);
+    QElapsedTimer wait_clock;
+    wait_clock.start();
+    QMutexLocker locker(&async_calls_mutex);
+    if (outstanding_async_calls + reserved_async_calls >= window) {
+        statistics.async_call_window_waits.fetchAndAddRelaxed(1);
+        do {
+            if (timeout_ms < 0) {
+                async_call_finished.wait(&async_calls_mutex);
+                continue;
+            }
+            qint64 remaining_ms = timeout_ms - wait_clock.elapsed();
+            if (remaining_ms <= 0)
+                return false;
+            async_call_finished.wait(&async_calls_mutex, ulong(remaining_ms));
+        } while (outstanding_async_calls + reserved_async_calls >= window);
+    }
+    reserved_async_calls++;
     return true;
 }
 
-QDBusError RemoteDBusConnection::lastError() const
+// Called from asynchronous call thread, if call wasn't sent
+void RemoteDBusConnectionTunnel::cancelAsyncCallReservation()
 {
-    if (!isConnectionOpened())
-        return QDBusError();
-    return ref->lastError();
+    QMutexLocker locker(&async_calls_mutex);
+    reserved_async_calls--;
+    async_call_finished.wakeAll();
 }
 
-bool RemoteDBusConnection::send(const QDBusMessage &message)
+// Called from asynchronous call thread, turns reservation (if any) into outstanding call released when it finishes
+void RemoteDBusConnectionTunnel::trackAsyncCall(const QDBusPendingCall &call, bool reserved)
 {
-    return executeWrappedOperation([&]() {
-        return ref->send(message);
+    async_calls_mutex.lock();
+    if (reserved)
+        reserved_async_calls--;
+    outstanding_async_calls++;
+    async_calls_mutex.unlock();
+    // Watcher is created in this object thread, since calling thread may have no event loop
+    // (and may be blocked waiting for window itself)
+    QtExtra::postQueued(this, [this, call]() {
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call, this);
+        Q_CHECK_PTR(watcher);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         this, [this](QDBusPendingCallWatcher *finished_watcher) {
+            async_calls_mutex.lock();
+            outstanding_async_calls--;
+            async_call_finished.wakeAll();
+            async_calls_mutex.unlock();
+            finished_watcher->deleteLater();
+        });
     });
 }
 
-bool RemoteDBusConnection::registerObject(const QString &path, QObject *object, QDBusConnection::RegisterOptions options)
+bool RemoteDBusConnectionTunnel::hasOutstandingAsyncCalls()
 {
-    return executeWrappedOperation([&]() {
-        return ref->registerObject(path, object, options);
-    });
+    QMutexLocker locker(&async_calls_mutex);
+    return (outstanding_async_calls > 0);
 }
 
-bool RemoteDBusConnection::registerObject(const QString &path, const QString &interface, QObject *object, QDBusConnection::RegisterOptions options)
+bool RemoteDBusConnectionTunnel::isWrappedOperationInProgress()
 {
-    return executeWrappedOperation([&]() {
-        return ref->registerObject(path, interface, object, options);
-    });
+    for (int i = 0; i < wrapped_operation_slot_count; i++) {
+        if (wrapped_operation_slots[i].loadAcquire() != wrapped_operation_idle)
+            return true;
+    }
+    return false;
 }
 
-void RemoteDBusConnection::unregisterObject(const QString &path, QDBusConnection::UnregisterMode mode)
+void RemoteDBusConnectionTunnel::updateWrappedOperationWatchdog()
 {
-    executeWrappedOperation([&]() {
-        ref->unregisterObject(path, mode);
-        return ref->isConnected();
-    });
+    int timeout_ms = wrapped_operation_timeout_ms.load();
+    if ((timeout_ms == -1) || (remote_socket.state() != QAbstractSocket::ConnectedState)) {
+        wrapped_operation_watchdog.stop();
+        return;
+    }
+    wrapped_operation_watchdog.start(qMax(timeout_ms / wrapped_operation_watchdog_resolution, 1));
 }
 
-QObject *RemoteDBusConnection::objectRegisteredAt(const QString &path)
+void RemoteDBusConnectionTunnel::checkWrappedOperationDeadline()
 {
-    QObject *object = nullptr;
-    executeWrappedOperation([&]() {
-        object = ref->objectRegisteredAt(path);
-        return ref->isConnected();
-    });
-    return object;
+    int timeout_ms = wrapped_operation_timeout_ms.load();
+    if (timeout_ms == -1)
+        return;
+    qint64 now_ms = wrapped_operation_clock.elapsed();
+    bool timed_out = false;
+    for (int i = 0; i < wrapped_operation_slot_count; i++) {
+        qint64 start_ms = wrapped_operation_slots[i].loadAcquire();
+        if ((start_ms < 0) || (now_ms - start_ms < timeout_ms))
+            continue;
+        // Operation may finish concurrently, then it's not timed out
+        if (wrapped_operation_slots[i].testAndSetOrdered(start_ms, wrapped_operation_timed_out)) {
+            QTEXTRA_TRACE2(wrapped_operation_timeout, this, i);
+            timed_out = true;
+        }
+    }
+    // Abandoned operations just fail, their callers get error
+    if (timed_out && (wrapped_operation_timeout_policy.load() == RemoteDBusConnection::DropConnectionOnTimeout))
+        processWrappedOperationTimeout();
 }
 
-bool RemoteDBusConnection::registerVirtualObject(const QString &path, QDBusVirtualObject *object, QDBusConnection::VirtualObjectRegisterOption options)
+void RemoteDBusConnectionTunnel::processWrappedOperationTimeout()
 {
-    return executeWrappedOperation([&]() {
-        return ref->registerVirtualObject(path, object, options);
-    });
+    if (remote_socket.state() != QAbstractSocket::ConnectedState)
+        return;
+    statistics.wrapped_operation_teardowns.fetchAndAddRelaxed(1);
+    dropChannel();
 }
 
-bool RemoteDBusConnection::registerService(const QString &serviceName)
+// Closes connection considered dead, as if it was lost
+void RemoteDBusConnectionTunnel::dropChannel()
 {
-    return executeWrappedOperation([&]() {
-        return ref->registerService(serviceName);
-    });
+    if (remote_socket.state() != QAbstractSocket::ConnectedState)
+        return;
+    // Operations in progress fail on their own, since connection is gone
+    abortChannel();
+    Q_EMIT channelClosed(true);
 }
 
-bool RemoteDBusConnection::unregisterService(const QString &serviceName)
+RemoteDBusConnectionTunnelPool::RemoteDBusConnectionTunnelPool() :
+    threads(qMax(QThread::idealThreadCount(), 1), nullptr),
+    tunnels_count(threads.size(), 0)
 {
-    return executeWrappedOperation([&]() {
-        return ref->unregisterService(serviceName);
-    });
 }
 
-bool RemoteDBusConnection::constructInterface(std::function<void (const QDBusConnection &)> constructor)
+RemoteDBusConnectionTunnelPool::~RemoteDBusConnectionTunnelPool()
+{
+    for (QThread *thread : threads) {
+        if (thread == nullptr)
+            continue;
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+}
+
+// Picks least loaded thread
+QThread *RemoteDBusConnectionTunnelPool::acquireThread()
+{
+    QMutexLocker locker(&mutex);
+    int index = 0;
+    for (int i = 1; i < threads.size(); i++) {
+        if (tunnels_count[i] < tunnels_count[index])
+            index = i;
+    }
+    if (threads[index] == nullptr) {
+        threads[index] = new QThread();
+        Q_CHECK_PTR(threads[index]);
+        threads[index]->setObjectName(QString("RemoteDBusTunnel#%1").arg(index));
+        threads[index]->start();
+    }
+    tunnels_count[index]++;
+    return threads[index];
+}
+
+void RemoteDBusConnectionTunnelPool::releaseThread(QThread *thread)
+{
+    QMutexLocker locker(&mutex);
+    int index = threads.indexOf(thread);
+    Q_ASSERT(index != -1);
+    Q_ASSERT(tunnels_count[index] > 0);
+    tunnels_count[index]--;
+}
+
+RemoteDBusConnection::RemoteDBusConnection(const QString &name, QObject *parent) :
+    RemoteDBusConnection(name, DedicatedTunnelThread, parent)
+{
+}
+
+RemoteDBusConnection::RemoteDBusConnection(const QString &name, TunnelThreadPolicy thread_policy, QObject *parent) :
+    QObject(parent),
+    ref(nullptr), ref_name(name),
+    tunnel_thread(this),
+    tunnel_shared_thread(nullptr),
+    async_call_window(0),
+    signal_subscriptions_active(false),
+    auto_reconnect_enabled(false),
+    reconnect_initial_delay_ms(100), reconnect_max_delay_ms(30000), reconnect_jitter_percent(50),
+    reconnect_port(0), reconnect_protocol(QAbstractSocket::AnyIPProtocol),
+    close_requested(false),
+    reconnect_attempt(0),
+    reconnect_timer(this),
+    statistics_report_timer(this),
+    heartbeat_timer(this),
+    heartbeat_interval_ms(0), heartbeat_timeout_ms(0),
+    heartbeat_watcher(nullptr),
+    lazy_connection_enabled(false), lazy_idle_timeout_ms(0),
+    lazy_open_armed(false), lazy_open_in_progress(false), lazy_open_generation(0),
+    idle_close_pending(false), idle_relayed_bytes(0),
+    idle_timer(this), idle_check_active(0),
+    reply_cache_generation(0),
+    reply_cache_properties_ttl_ms(0), reply_cache_introspection_ttl_ms(0),
+    handshake_in_progress(false),
+    channel_closed_during_handshake(false),
+    handshake_ref(nullptr)
+{
+    reply_cache_clock.start();
+    qRegisterMetaType<RemoteDBusConnection::Statistics>();
+
+    reconnect_timer.setSingleShot(true);
+    QObject::connect(&reconnect_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnection::processReconnectTimeout);
+    QObject::connect(&statistics_report_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnection::processStatisticsReportTimeout);
+    QObject::connect(&heartbeat_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnection::sendHeartbeat);
+    QObject::connect(&idle_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnection::processIdleCheckTimeout);
+
+    tunnel = new RemoteDBusConnectionTunnel();
+    Q_CHECK_PTR(tunnel);
+    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelOpened,
+                     this, &RemoteDBusConnection::processTunnelChannelOpened);
+    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelClosed,
+                     this, &RemoteDBusConnection::processTunnelChannelClosed);
+    QObject::connect(tunnel, &RemoteDBusConnectionTunnel::channelError,
+                     this, &RemoteDBusConnection::connectionError);
+
+    if (thread_policy == SharedTunnelThread) {
+        tunnel_shared_thread = tunnel_pool()->acquireThread();
+        tunnel->moveToThread(tunnel_shared_thread);
+        return;
+    }
+    tunnel->moveToThread(&tunnel_thread);
+    QObject::connect(&tunnel_thread, &QThread::finished,
+                     tunnel, &RemoteDBusConnectionTunnel::deleteLater);
+    tunnel_thread.start();
+}
+
+RemoteDBusConnection::~RemoteDBusConnection()
+{
+    // Operations waiting for lazy opening in other threads give up
+    lazy_open_mutex.lock();
+    lazy_open_armed = false;
+    lazy_open_finished.wakeAll();
+    lazy_open_mutex.unlock();
+    if (handshake_in_progress) {
+        // Breaking channel makes handshake fail fast instead of waiting for its own timeout
+        QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
+        handshake_finished.acquire();
+        handshake_in_progress = false;
+        handshake_ref->disconnectFromBus(ref_name);
+        delete handshake_ref;
+        handshake_ref = nullptr;
+    }
+    if (isConnectionOpened()) {
+        QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
+        dropNativeDBusConnection();
+    }
+    if (tunnel_shared_thread != nullptr) {
+        // Shared thread keeps running, so tunnel is deleted there after pending events (abort included)
+        QObject::disconnect(tunnel, nullptr, this, nullptr);
+        tunnel->deleteLater();
+        tunnel_pool()->releaseThread(tunnel_shared_thread);
+        return;
+    }
+    tunnel_thread.quit();
+    tunnel_thread.wait();
+    Q_ASSERT(tunnel_thread.isFinished());
+}
+
+void RemoteDBusConnection::setConnectionTimeout(int timeout_ms)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->connection_timeout_ms = timeout_ms;
+}
+
+void RemoteDBusConnection::setWrappedOperationTimeout(int timeout_ms)
+{
+    tunnel->wrapped_operation_timeout_ms.store(timeout_ms);
+    QTMETAMETHOD_INVOKE_QUEUED(tunnel, updateWrappedOperationWatchdog);
+    QtExtra::invokeQueued(this, &RemoteDBusConnection::applyWrappedOperationTimeoutPolicy);
+}
+
+void RemoteDBusConnection::setWrappedOperationTimeoutPolicy(WrappedOperationTimeoutPolicy policy)
+{
+    tunnel->wrapped_operation_timeout_policy.store(policy);
+    QtExtra::invokeQueued(this, &RemoteDBusConnection::applyWrappedOperationTimeoutPolicy);
+}
+
+// Calls made via bus interface (registerService(), etc.) are given wrapped operation timeout when abandoning,
+// so abandoned ones give up at same deadline (QtDBus then discards their late replies itself).
+// Interface is shared by all threads, so it's changed only here (in this object thread).
+void RemoteDBusConnection::applyWrappedOperationTimeoutPolicy()
+{
+    QDBusConnection *native_ref = ref.load();
+    if (native_ref == nullptr)
+        return;
+    bool abandon = (tunnel->wrapped_operation_timeout_policy.load() == AbandonOperationOnTimeout);
+    native_ref->interface()->setTimeout(abandon ? tunnel->wrapped_operation_timeout_ms.load() : -1);
+}
+
+bool RemoteDBusConnection::setKeepaliveEnabled(bool enabled)
+{
+#ifdef Q_OS_WIN
+    if (isConnectionOpened())
+        return false;
+#endif
+    QTMETAMETHOD_INVOKE_ARGS2(tunnel, setRemoteSocketOption, Qt::BlockingQueuedConnection,
+                                     (QAbstractSocket::SocketOption, QAbstractSocket::KeepAliveOption),
+                                     (const QVariant&, QVariant((int)enabled)));
+    return true;
+}
+
+void RemoteDBusConnection::setLowDelayOption(bool enabled)
+{
+    QTMETAMETHOD_INVOKE_ARGS2(tunnel, setRemoteSocketOption, Qt::BlockingQueuedConnection,
+                                     (QAbstractSocket::SocketOption, QAbstractSocket::LowDelayOption),
+                                     (const QVariant&, QVariant((int)enabled)));
+}
+
+#ifndef QT_NO_SSL
+void RemoteDBusConnection::setSslConfiguration(const QSslConfiguration &configuration)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->ssl_enabled = true;
+    tunnel->ssl_configuration = configuration;
+}
+
+void RemoteDBusConnection::unsetSslConfiguration()
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->ssl_enabled = false;
+    tunnel->ssl_configuration = QSslConfiguration();
+}
+#endif
+
+void RemoteDBusConnection::setHappyEyeballsEnabled(bool enabled)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->happy_eyeballs_enabled = enabled;
+}
+
+void RemoteDBusConnection::setEarlyHandshakeEnabled(bool enabled)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->early_channel_open_enabled = enabled;
+}
+
+void RemoteDBusConnection::setRelayCompression(bool enabled, int level)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->compression_enabled = enabled;
+    tunnel->compression_level = level;
+}
+
+bool RemoteDBusConnection::setLocalTransport(LocalTransport transport)
+{
+#ifndef Q_OS_UNIX
+    if (transport == LocalUnixSocketTransport)
+        return false;
+#endif
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->local_transport = transport;
+    return true;
+}
+
+void RemoteDBusConnection::setAutoReconnectEnabled(bool enabled)
+{
+    auto_reconnect_enabled = enabled;
+    if (!enabled) {
+        reconnect_timer.stop();
+        reconnect_attempt = 0;
+    }
+}
+
+void RemoteDBusConnection::setAutoReconnectBackoff(int initial_delay_ms, int max_delay_ms, int jitter_percent)
+{
+    reconnect_initial_delay_ms = qMax(initial_delay_ms, 0);
+    reconnect_max_delay_ms = qMax(max_delay_ms, reconnect_initial_delay_ms);
+    reconnect_jitter_percent = qBound(0, jitter_percent, 100);
+}
+
+void RemoteDBusConnection::setLazyConnectionEnabled(bool enabled, int idle_timeout_ms)
+{
+    lazy_connection_enabled = enabled;
+    lazy_idle_timeout_ms = qMax(idle_timeout_ms, 0);
+    if (!enabled || (lazy_idle_timeout_ms == 0)) {
+        idle_timer.stop();
+        idle_check_active.storeRelease(0);
+    }
+}
+
+void RemoteDBusConnection::setHeartbeat(int interval_ms, int timeout_ms)
+{
+    heartbeat_interval_ms = qMax(interval_ms, 0);
+    heartbeat_timeout_ms = (timeout_ms > 0) ? timeout_ms : heartbeat_interval_ms;
+    if ((heartbeat_interval_ms > 0) && isConnectionOpened())
+        heartbeat_timer.start(heartbeat_interval_ms);
+    else
+        heartbeat_timer.stop();
+}
+
+void RemoteDBusConnection::setAsyncCallWindow(int max_outstanding)
+{
+    async_call_window.store(qMax(max_outstanding, 0));
+}
+
+void RemoteDBusConnection::setReplyCacheTtl(int properties_ttl_ms, int introspection_ttl_ms)
+{
+    reply_cache_properties_ttl_ms.store(qMax(properties_ttl_ms, 0));
+    reply_cache_introspection_ttl_ms.store(qMax(introspection_ttl_ms, 0));
+    QMutexLocker locker(&reply_cache_mutex);
+    // Entries keep expiry computed with previous lifetime, drop them to apply new one at once
+    reply_cache.clear();
+    reply_cache_generation++;
+}
+
+void RemoteDBusConnection::clearReplyCache()
+{
+    QMutexLocker locker(&reply_cache_mutex);
+    reply_cache.clear();
+    reply_cache_generation++;
+}
+
+RemoteDBusConnection::Statistics RemoteDBusConnection::statistics() const
+{
+    const StatisticsCounters &counters = tunnel->statistics;
+    Statistics result;
+    result.bytes_remote_to_local = counters.bytes_remote_to_local.load();
+    result.bytes_local_to_remote = counters.bytes_local_to_remote.load();
+    result.wrapped_operations = counters.wrapped_operations.load();
+    result.wrapped_operations_failed = counters.wrapped_operations_failed.load();
+    result.wrapped_operations_timed_out = counters.wrapped_operations_timed_out.load();
+    result.wrapped_operation_slot_waits = counters.wrapped_operation_slot_waits.load();
+    result.wrapped_operation_slot_wait_us = counters.wrapped_operation_slot_wait_us.load();
+    result.wrapped_operation_latency = counters.wrapped_operation_latency.percentiles();
+    result.connections_opened = counters.connections_opened.load();
+    result.connections_closed_idle = counters.connections_closed_idle.load();
+    result.connection_attempts_failed = counters.connection_attempts_failed.load();
+    result.wrapped_operation_teardowns = counters.wrapped_operation_teardowns.load();
+    result.last_connect_duration_us = counters.last_connect_duration_us.load();
+    result.last_handshake_duration_us = counters.last_handshake_duration_us.load();
+    result.reply_cache_hits = counters.reply_cache_hits.load();
+    result.reply_cache_misses = counters.reply_cache_misses.load();
+    result.async_call_window_waits = counters.async_call_window_waits.load();
+    result.async_call_window_timeouts = counters.async_call_window_timeouts.load();
+    result.heartbeat_failures = counters.heartbeat_failures.load();
+    result.last_heartbeat_rtt_us = counters.last_heartbeat_rtt_us.load();
+    return result;
+}
+
+void RemoteDBusConnection::resetStatistics()
+{
+    StatisticsCounters &counters = tunnel->statistics;
+    counters.bytes_remote_to_local.store(0);
+    counters.bytes_local_to_remote.store(0);
+    counters.wrapped_operations.store(0);
+    counters.wrapped_operations_failed.store(0);
+    counters.wrapped_operations_timed_out.store(0);
+    counters.wrapped_operation_slot_waits.store(0);
+    counters.wrapped_operation_slot_wait_us.store(0);
+    counters.wrapped_operation_latency.reset();
+    counters.connections_opened.store(0);
+    counters.connections_closed_idle.store(0);
+    counters.connection_attempts_failed.store(0);
+    counters.wrapped_operation_teardowns.store(0);
+    counters.last_connect_duration_us.store(0);
+    counters.last_handshake_duration_us.store(0);
+    counters.reply_cache_hits.store(0);
+    counters.reply_cache_misses.store(0);
+    counters.async_call_window_waits.store(0);
+    counters.async_call_window_timeouts.store(0);
+    counters.heartbeat_failures.store(0);
+    counters.last_heartbeat_rtt_us.store(0);
+}
+
+void RemoteDBusConnection::setStatisticsReportInterval(int interval_ms)
+{
+    if (interval_ms <= 0) {
+        statistics_report_timer.stop();
+        return;
+    }
+    statistics_report_timer.start(interval_ms);
+}
+
+void RemoteDBusConnection::processStatisticsReportTimeout()
+{
+    Q_EMIT statisticsReported(statistics());
+}
+
+void RemoteDBusConnection::setRelayBufferWatermarks(qint64 high_watermark, qint64 low_watermark)
+{
+    Q_ASSERT((high_watermark >= 0) && (low_watermark >= 0));
+    Q_ASSERT((high_watermark == 0) || (low_watermark <= high_watermark));
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->relay_high_watermark = high_watermark;
+    tunnel->relay_low_watermark = qMin(low_watermark, high_watermark);
+}
+
+void RemoteDBusConnection::setSocketBufferSizes(int send_buffer_size, int receive_buffer_size)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->socket_send_buffer_size = qMax(send_buffer_size, 0);
+    tunnel->socket_receive_buffer_size = qMax(receive_buffer_size, 0);
+}
+
+void RemoteDBusConnection::setRelayChunkSize(int size)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->relay_chunk_size = qMax(size, 0);
+}
+
+#ifdef Q_OS_LINUX
+void RemoteDBusConnection::setKeepaliveParameters(int keepcnt, int keepidle, int keepintvl)
+{
+    tunnel->mutex.lock();
+    tunnel->keepalive_params.active = true;
+    tunnel->keepalive_params.keepcnt = keepcnt;
+    tunnel->keepalive_params.keepidle = keepidle;
+    tunnel->keepalive_params.keepintvl = keepintvl;
+    tunnel->mutex.unlock();
+    if (isConnectionOpened())
+        QTMETAMETHOD_INVOKE(tunnel, applyRemoteSocketKeepaliveParams, Qt::BlockingQueuedConnection);
+}
+
+void RemoteDBusConnection::unsetKeepaliveParameters()
+{
+    tunnel->mutex.lock();
+    tunnel->keepalive_params.active = false;
+    tunnel->mutex.unlock();
+}
+
+void RemoteDBusConnection::setTcpQuickAckEnabled(bool enabled)
+{
+    tunnel->tcp_quickack_enabled.store(enabled ? 1 : 0);
+}
+
+void RemoteDBusConnection::setTcpCorkEnabled(bool enabled)
+{
+    tunnel->tcp_cork_enabled.store(enabled ? 1 : 0);
+}
+
+void RemoteDBusConnection::setCongestionControl(const QString &algorithm)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->congestion_control = algorithm.toLatin1();
+}
+
+void RemoteDBusConnection::setFastOpenEnabled(bool enabled)
+{
+    QMutexLocker locker(&tunnel->mutex);
+    tunnel->fast_open_enabled = enabled;
+}
+
+void RemoteDBusConnection::setZeroCopyRelayEnabled(bool enabled)
+{
+    tunnel->mutex.lock();
+    tunnel->splice_relay_enabled = enabled;
+    tunnel->mutex.unlock();
+}
+#endif
+
+bool RemoteDBusConnection::isConnectionOpened() const
+{
+    return (ref.loadAcquire() != nullptr);
+}
+
+bool RemoteDBusConnection::openConnection(const QString &hostname, quint16 port, QAbstractSocket::NetworkLayerProtocol protocol)
+{
+    if (isConnectionOpened())
+        return false;
+    reconnect_hostname = hostname;
+    reconnect_port = port;
+    reconnect_protocol = protocol;
+    close_requested = false;
+    reconnect_attempt = 0;
+    reconnect_timer.stop();
+    if (lazy_connection_enabled) {
+        // Opened by first wrapped operation (see openLazyConnection())
+        QMutexLocker locker(&lazy_open_mutex);
+        lazy_open_armed = true;
+        return true;
+    }
+    QtExtra::invokeQueued(tunnel, &RemoteDBusConnectionTunnel::openChannel, hostname, port, protocol);
+    return true;
+}
+
+bool RemoteDBusConnection::closeConnection()
+{
+    close_requested = true;
+    reconnect_timer.stop();
+    lazy_open_mutex.lock();
+    lazy_open_armed = false;
+    lazy_open_finished.wakeAll();
+    lazy_open_mutex.unlock();
+    if (!isConnectionOpened())
+        return false;
+    QTMETAMETHOD_INVOKE_QUEUED(tunnel, closeChannel);
+    dropNativeDBusConnection();
+    return true;
+}
+
+QDBusError RemoteDBusConnection::lastError() const
+{
+    if (!isConnectionOpened())
+        return QDBusError();
+    return nativeDBusConnection().lastError();
+}
+
+bool RemoteDBusConnection::send(const QDBusMessage &message)
 {
-    return executeWrappedOperation([&]() {
-        constructor(*ref);
-        return ref->isConnected();
+    return executeWrappedOperation([message](QDBusConnection &connection) {
+        return connection.send(message);
     });
 }
 
-void RemoteDBusConnection::processTunnelChannelOpened(bool success, quint16 local_port)
+QVector<bool> RemoteDBusConnection::sendBatch(const QVector<QDBusMessage> &messages)
+{
+    QVector<bool> results(messages.size(), false);
+    if (messages.isEmpty())
+        return results;
+#ifdef Q_OS_LINUX
+    bool corked = (tunnel->tcp_cork_enabled.load() != 0);
+    if (corked)
+        QTMETAMETHOD_INVOKE_QUEUED_ARGS1(tunnel, setRemoteSocketCorked, (bool, true));
+#endif
+    std::shared_ptr<QVector<bool> > sent = std::make_shared<QVector<bool> >(results);
+    bool completed = false;
+    executeWrappedOperation([messages, sent](QDBusConnection &connection) {
+        bool success = true;
+        for (int i = 0; i < messages.size(); i++) {
+            (*sent)[i] = connection.send(messages.at(i));
+            success &= (*sent)[i];
+        }
+        return success;
+    }, &completed);
+    if (completed)
+        results = *sent;
+#ifdef Q_OS_LINUX
+    if (corked)
+        QTMETAMETHOD_INVOKE_QUEUED_ARGS1(tunnel, setRemoteSocketCorked, (bool, false));
+#endif
+    return results;
+}
+
+bool RemoteDBusConnection::registerObject(const QString &path, QObject *object, QDBusConnection::RegisterOptions options)
+{
+    return registerObject(path, QString(), object, options);
+}
+
+bool RemoteDBusConnection::registerObject(const QString &path, const QString &interface, QObject *object, QDBusConnection::RegisterOptions options)
 {
+    bool success = executeWrappedOperation([path, interface, object, options](QDBusConnection &connection) {
+        if (interface.isEmpty())
+            return connection.registerObject(path, object, options);
+        return connection.registerObject(path, interface, object, options);
+    });
     if (success) {
-        QString dbus_address = QString("tcp:host=localhost,port=%1").arg(local_port);
-        ref = new QDBusConnection(QDBusConnection::connectToBus(dbus_address, ref_name));
-        Q_CHECK_PTR(ref);
-        if (ref->isConnected()) {
-            Q_EMIT connectionOpened(true);
+        QMutexLocker locker(&registry_mutex);
+        registered_objects.insert(path, RegisteredObject{interface, object, int(options), false});
+    }
+    return success;
+}
+
+void RemoteDBusConnection::unregisterObject(const QString &path, QDBusConnection::UnregisterMode mode)
+{
+    registry_mutex.lock();
+    registered_objects.remove(path);
+    if (mode == QDBusConnection::UnregisterTree) {
+        QString prefix = path.endsWith("/") ? path : path + "/";
+        for (auto it = registered_objects.begin(); it != registered_objects.end();) {
+            if (it.key().startsWith(prefix))
+                it = registered_objects.erase(it);
+            else
+                ++it;
+        }
+    }
+    registry_mutex.unlock();
+    executeWrappedOperation([path, mode](QDBusConnection &connection) {
+        connection.unregisterObject(path, mode);
+        return connection.isConnected();
+    });
+}
+
+QObject *RemoteDBusConnection::objectRegisteredAt(const QString &path)
+{
+    std::shared_ptr<QPointer<QObject> > object = std::make_shared<QPointer<QObject> >();
+    bool completed = false;
+    executeWrappedOperation([path, object](QDBusConnection &connection) {
+        *object = connection.objectRegisteredAt(path);
+        return connection.isConnected();
+    }, &completed);
+    return completed ? object->data() : nullptr;
+}
+
+bool RemoteDBusConnection::registerVirtualObject(const QString &path, QDBusVirtualObject *object, QDBusConnection::VirtualObjectRegisterOption options)
+{
+    bool success = executeWrappedOperation([path, object, options](QDBusConnection &connection) {
+        return connection.registerVirtualObject(path, object, options);
+    });
+    if (success) {
+        QMutexLocker locker(&registry_mutex);
+        registered_objects.insert(path, RegisteredObject{QString(), object, int(options), true});
+    }
+    return success;
+}
+
+bool RemoteDBusConnection::registerService(const QString &serviceName)
+{
+    bool success = executeWrappedOperation([serviceName](QDBusConnection &connection) {
+        return connection.registerService(serviceName);
+    });
+    if (success) {
+        QMutexLocker locker(&registry_mutex);
+        if (!registered_services.contains(serviceName))
+            registered_services.append(serviceName);
+    }
+    return success;
+}
+
+bool RemoteDBusConnection::unregisterService(const QString &serviceName)
+{
+    registry_mutex.lock();
+    registered_services.removeAll(serviceName);
+    registry_mutex.unlock();
+    return executeWrappedOperation([serviceName](QDBusConnection &connection) {
+        return connection.unregisterService(serviceName);
+    });
+}
+
+bool RemoteDBusConnection::constructInterface(std::function<void (const QDBusConnection &)> constructor)
+{
+    // Constructor may refer to caller data, so it can't be abandoned
+    return executeWrappedOperation([&](QDBusConnection &connection) {
+        constructor(connection);
+        return connection.isConnected();
+    }, nullptr, false);
+}
+
+QDBusPendingCall RemoteDBusConnection::asyncCall(const QDBusMessage &message, int timeout)
+{
+    bool introspection = false;
+    QString cache_key = replyCacheKey(message, &introspection);
+    int cache_ttl_ms = introspection ? reply_cache_introspection_ttl_ms.load() : reply_cache_properties_ttl_ms.load();
+    if (cache_ttl_ms <= 0)
+        cache_key.clear();
+    quint64 cache_generation = 0;
+    if (!cache_key.isEmpty()) {
+        QDBusMessage reply;
+        if (lookupCachedReply(cache_key, message, &reply)) {
+            tunnel->statistics.reply_cache_hits.fetchAndAddRelaxed(1);
+            return QDBusPendingCall::fromCompletedCall(reply);
+        }
+        tunnel->statistics.reply_cache_misses.fetchAndAddRelaxed(1);
+    }
+    if (timeout == -1)
+        timeout = tunnel->wrapped_operation_timeout_ms.load();
+    // Waiting for calls window and for opening on demand counts against call deadline
+    const int call_timeout = timeout;
+    QElapsedTimer window_clock;
+    window_clock.start();
+    int window = async_call_window.load();
+    bool windowed = (window > 0);
+    if (windowed && !tunnel->reserveAsyncCall(window, timeout)) {
+        tunnel->statistics.async_call_window_timeouts.fetchAndAddRelaxed(1);
+        return QDBusPendingCall::fromError(QDBusError(QDBusError::NoReply, "Call timed out waiting for calls window"));
+    }
+    if (windowed && (call_timeout > 0))
+        timeout = qMax(call_timeout - int(window_clock.elapsed()), 1);
+    if (!isConnectionOpened()) {
+        openLazyConnection((timeout > 0) ? timeout : dbus_default_call_timeout_ms);
+        if (call_timeout > 0)
+            timeout = qMax(call_timeout - int(window_clock.elapsed()), 1);
+    }
+    // Sending doesn't block, but it's still accounted as operation in progress
+    int slot = tunnel->startWrappedOperation(timeout);
+    if (slot == -1) {
+        if (windowed)
+            tunnel->cancelAsyncCallReservation();
+        return QDBusPendingCall::fromError(QDBusError(QDBusError::NoReply, "Call timed out waiting for free slot"));
+    }
+    QDBusConnection connection = nativeDBusConnection();
+    if (!connection.isConnected()) {
+        tunnel->stopWrappedOperation(slot);
+        if (windowed)
+            tunnel->cancelAsyncCallReservation();
+        return QDBusPendingCall::fromError(QDBusError(QDBusError::Disconnected, "Remote D-Bus connection isn't opened"));
+    }
+    // Reply is cached only if invalidation signals are already subscribed when call is sent
+    if (!cache_key.isEmpty()) {
+        if (subscribeReplyCacheInvalidation(connection, message.service(), message.path())) {
+            QMutexLocker locker(&reply_cache_mutex);
+            cache_generation = reply_cache_generation;
         } else {
-            QDBusError dbus_error = ref->lastError();
-            dropNativeDBusConnection();
-            QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
-            Q_EMIT connectionError("D-Bus connection failed with " + formatDBusErrorDetails(&dbus_error));
-            Q_EMIT connectionOpened(false);
+            cache_key.clear();
         }
+    }
+    QDBusPendingCall call = connection.asyncCall(message, timeout);
+    tunnel->stopWrappedOperation(slot);
+    // Idle check keeps connection opened while any call is outstanding
+    if (windowed || idle_check_active.loadAcquire())
+        tunnel->trackAsyncCall(call, windowed);
+    if (!cache_key.isEmpty()) {
+        // Watcher is moved to this object thread, since calling thread may have no event loop
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
+        Q_CHECK_PTR(watcher);
+        watcher->moveToThread(thread());
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         this, [this, cache_key, message, cache_generation](QDBusPendingCallWatcher *finished_watcher) {
+            storeCachedReply(cache_key, message, finished_watcher->reply(), cache_generation);
+            finished_watcher->deleteLater();
+        });
+    }
+    return call;
+}
+
+bool RemoteDBusConnection::lookupCachedReply(const QString &key, const QDBusMessage &message, QDBusMessage *reply)
+{
+    QMutexLocker locker(&reply_cache_mutex);
+    auto it = reply_cache.find(key);
+    if (it == reply_cache.end())
+        return false;
+    if (it->expiry_ms <= reply_cache_clock.elapsed()) {
+        reply_cache.erase(it);
+        return false;
+    }
+    *reply = message.createReply(it->arguments);
+    return true;
+}
+
+void RemoteDBusConnection::storeCachedReply(const QString &key, const QDBusMessage &message, const QDBusMessage &reply,
+                                            quint64 generation)
+{
+    if (reply.type() != QDBusMessage::ReplyMessage)
+        return;
+    bool introspection = (message.interface() == QLatin1String(dbus_introspectable_interface));
+    int ttl_ms = introspection ? reply_cache_introspection_ttl_ms.load() : reply_cache_properties_ttl_ms.load();
+    if (ttl_ms <= 0)
+        return;
+    CachedReply entry;
+    entry.service = message.service();
+    entry.path = message.path();
+    entry.introspection = introspection;
+    if (!introspection)
+        entry.property_interface = message.arguments().first().toString();
+    entry.arguments = reply.arguments();
+    entry.expiry_ms = reply_cache_clock.elapsed() + ttl_ms;
+    QMutexLocker locker(&reply_cache_mutex);
+    if (generation != reply_cache_generation)
+        return;
+    reply_cache.insert(key, entry);
+}
+
+bool RemoteDBusConnection::addSignalSubscription(const QString &rule)
+{
+    QMutexLocker locker(&registry_mutex);
+    return addSignalSubscriptionReference(normalizedMatchRule(rule));
+}
+
+bool RemoteDBusConnection::removeSignalSubscription(const QString &rule)
+{
+    QMutexLocker locker(&registry_mutex);
+    return removeSignalSubscriptionReference(normalizedMatchRule(rule));
+}
+
+bool RemoteDBusConnection::setSignalSubscriptions(const QStringList &rules)
+{
+    QStringList normalized_rules;
+    for (const QString &rule : rules) {
+        QString normalized_rule = normalizedMatchRule(rule);
+        if (!normalized_rules.contains(normalized_rule))
+            normalized_rules.append(normalized_rule);
+    }
+    // Declared set is replaced under same lock as references update, so concurrent calls don't interleave
+    QMutexLocker locker(&registry_mutex);
+    QStringList previous_rules = declared_signal_subscriptions;
+    declared_signal_subscriptions = normalized_rules;
+    // Adding first, so rules present in both sets never drop to zero references
+    bool success = true;
+    for (const QString &rule : normalized_rules) {
+        if (!previous_rules.contains(rule))
+            success = addSignalSubscriptionReference(rule) && success;
+    }
+    for (const QString &rule : previous_rules) {
+        if (!normalized_rules.contains(rule))
+            success = removeSignalSubscriptionReference(rule) && success;
+    }
+    return success;
+}
+
+// Request is sent under same lock as references update, so daemon gets them in same order
+// (registry_mutex must be locked)
+bool RemoteDBusConnection::addSignalSubscriptionReference(const QString &normalized_rule)
+{
+    bool first_reference = (++signal_subscriptions[normalized_rule] == 1);
+    if (!first_reference || !signal_subscriptions_active)
+        return true;
+    return sendMatchRuleRequest("AddMatch", normalized_rule);
+}
+
+// Same as addSignalSubscriptionReference()
+bool RemoteDBusConnection::removeSignalSubscriptionReference(const QString &normalized_rule)
+{
+    auto it = signal_subscriptions.find(normalized_rule);
+    if (it == signal_subscriptions.end())
+        return false;
+    bool last_reference = (--it.value() == 0);
+    if (last_reference)
+        signal_subscriptions.erase(it);
+    if (!last_reference || !signal_subscriptions_active)
+        return true;
+    return sendMatchRuleRequest("RemoveMatch", normalized_rule);
+}
+
+QStringList RemoteDBusConnection::signalSubscriptions()
+{
+    QMutexLocker locker(&registry_mutex);
+    return signal_subscriptions.keys();
+}
+
+// Sends request without waiting for reply (failure is signalled with connectionError()), registry_mutex must be locked
+bool RemoteDBusConnection::sendMatchRuleRequest(const char *method, const QString &rule)
+{
+    QDBusConnection connection = nativeDBusConnection();
+    if (!connection.isConnected())
+        return false;
+    QDBusMessage message = QDBusMessage::createMethodCall(dbus_daemon_service, dbus_daemon_path,
+                                                          dbus_daemon_interface, method);
+    message << rule;
+    QDBusPendingCall call = connection.asyncCall(message, tunnel->wrapped_operation_timeout_ms.load());
+    if (call.isFinished() && call.isError())
+        return false;
+    // Watcher is moved to this object thread, since calling thread may have no event loop
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
+    Q_CHECK_PTR(watcher);
+    watcher->moveToThread(thread());
+    QString request = QString("%1 for rule \"%2\"").arg(method).arg(rule);
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                     this, [this, request](QDBusPendingCallWatcher *finished_watcher) {
+        if (finished_watcher->isError()) {
+            QDBusError dbus_error = finished_watcher->error();
+            Q_EMIT connectionError(request + " failed with " + formatDBusErrorDetails(&dbus_error));
+        }
+        finished_watcher->deleteLater();
+    });
+    return true;
+}
+
+// Rules are sent at once without waiting for replies, so opening doesn't take extra round trips
+void RemoteDBusConnection::replaySignalSubscriptions()
+{
+    QMutexLocker locker(&registry_mutex);
+    signal_subscriptions_active = true;
+    for (auto it = signal_subscriptions.constBegin(); it != signal_subscriptions.constEnd(); ++it)
+        sendMatchRuleRequest("AddMatch", it.key());
+}
+
+void RemoteDBusConnection::sendHeartbeat()
+{
+    // Next ping is sent only after previous one is answered (or failed)
+    if (!isConnectionOpened() || (heartbeat_watcher != nullptr))
+        return;
+    QDBusMessage ping = QDBusMessage::createMethodCall(dbus_daemon_service, dbus_daemon_path,
+                                                       "org.freedesktop.DBus.Peer", "Ping");
+    heartbeat_clock.start();
+    heartbeat_watcher = new QDBusPendingCallWatcher(ref.load()->asyncCall(ping, heartbeat_timeout_ms), this);
+    Q_CHECK_PTR(heartbeat_watcher);
+    QObject::connect(heartbeat_watcher, &QDBusPendingCallWatcher::finished,
+                     this, &RemoteDBusConnection::processHeartbeatReply);
+}
+
+void RemoteDBusConnection::processHeartbeatReply(QDBusPendingCallWatcher *watcher)
+{
+    Q_ASSERT(watcher == heartbeat_watcher);
+    heartbeat_watcher = nullptr;
+    watcher->deleteLater();
+    if (!watcher->isError()) {
+        qint64 rtt_us = heartbeat_clock.nsecsElapsed() / 1000;
+        tunnel->statistics.last_heartbeat_rtt_us.store(rtt_us);
+        Q_EMIT heartbeatRoundTrip(rtt_us);
+        return;
+    }
+    tunnel->statistics.heartbeat_failures.fetchAndAddRelaxed(1);
+    QDBusError dbus_error = watcher->error();
+    if ((dbus_error.type() != QDBusError::NoReply) && (dbus_error.type() != QDBusError::Timeout)) {
+        // Remote side answered, so link is alive
+        Q_EMIT connectionError("Heartbeat failed with " + formatDBusErrorDetails(&dbus_error));
+        return;
+    }
+    Q_EMIT connectionError("Heartbeat reply timed out, connection is considered lost");
+    QTMETAMETHOD_INVOKE_QUEUED(tunnel, dropChannel);
+}
+
+// Match rules are scoped to cached object path and its service, so other signals of remote bus don't cross the link.
+// Sender of PropertiesChanged isn't matched, since QtDBus would resolve service owner with blocking call.
+// May be called from any thread, subscriptions are kept until connection closes.
+bool RemoteDBusConnection::subscribeReplyCacheInvalidation(QDBusConnection &connection, const QString &service,
+                                                           const QString &path)
+{
+    reply_cache_mutex.lock();
+    bool service_subscribed = reply_cache_services.contains(service);
+    bool object_subscribed = reply_cache_objects.contains(path);
+    reply_cache_mutex.unlock();
+    if (!service_subscribed) {
+        if (!connection.connect(dbus_daemon_service, dbus_daemon_path, dbus_daemon_interface, "NameOwnerChanged",
+                                QStringList() << service, QString(),
+                                this, SLOT(processNameOwnerChanged(QString,QString,QString))))
+            return false;
+        QMutexLocker locker(&reply_cache_mutex);
+        reply_cache_services.insert(service);
+    }
+    if (!object_subscribed) {
+        if (!connection.connect(QString(), path, dbus_properties_interface, "PropertiesChanged",
+                                this, SLOT(processPropertiesChanged(QDBusMessage))))
+            return false;
+        QMutexLocker locker(&reply_cache_mutex);
+        reply_cache_objects.insert(path);
+    }
+    return true;
+}
+
+void RemoteDBusConnection::processPropertiesChanged(const QDBusMessage &message)
+{
+    const QList<QVariant> arguments = message.arguments();
+    QString property_interface = arguments.isEmpty() ? QString() : arguments.first().toString();
+    QMutexLocker locker(&reply_cache_mutex);
+    reply_cache_generation++;
+    // Sender is unique name, while entries may be keyed by well-known one, so service isn't compared
+    for (auto it = reply_cache.begin(); it != reply_cache.end();) {
+        if (!it->introspection && (it->path == message.path()) &&
+                (it->property_interface.isEmpty() || (it->property_interface == property_interface)))
+            it = reply_cache.erase(it);
+        else
+            ++it;
+    }
+}
+
+void RemoteDBusConnection::processNameOwnerChanged(const QString &name, const QString &old_owner, const QString &new_owner)
+{
+    Q_UNUSED(new_owner);
+    QMutexLocker locker(&reply_cache_mutex);
+    reply_cache_generation++;
+    for (auto it = reply_cache.begin(); it != reply_cache.end();) {
+        if ((it->service == name) || (!old_owner.isEmpty() && (it->service == old_owner)))
+            it = reply_cache.erase(it);
+        else
+            ++it;
+    }
+}
+
+QDBusPendingCall RemoteDBusConnection::registerServiceAsync(const QString &serviceName)
+{
+    // Same request as QDBusConnection::registerService() does
+    QDBusMessage message = QDBusMessage::createMethodCall(dbus_daemon_service, dbus_daemon_path,
+                                                          dbus_daemon_interface, "RequestName");
+    message << serviceName << dbus_name_flag_do_not_queue;
+    QDBusPendingCall call = asyncCall(message);
+    if (call.isFinished() && call.isError())
+        return call;
+    // Service is replayed at reconnection only if daemon granted name
+    // (watcher is moved to this object thread, since calling thread may have no event loop)
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(call);
+    Q_CHECK_PTR(watcher);
+    watcher->moveToThread(thread());
+    QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                     this, [this, serviceName](QDBusPendingCallWatcher *finished_watcher) {
+        finished_watcher->deleteLater();
+        QDBusMessage reply = finished_watcher->reply();
+        if ((reply.type() != QDBusMessage::ReplyMessage) || reply.arguments().isEmpty())
+            return;
+        uint result = reply.arguments().first().toUInt();
+        if ((result != dbus_request_name_reply_primary_owner) && (result != dbus_request_name_reply_already_owner))
+            return;
+        QMutexLocker locker(&registry_mutex);
+        if (!registered_services.contains(serviceName))
+            registered_services.append(serviceName);
+    });
+    return call;
+}
+
+void RemoteDBusConnection::unregisterAll()
+{
+    registry_mutex.lock();
+    QStringList services = registered_services;
+    QStringList object_paths = registered_objects.keys();
+    if (signal_subscriptions_active) {
+        for (auto it = signal_subscriptions.constBegin(); it != signal_subscriptions.constEnd(); ++it)
+            sendMatchRuleRequest("RemoveMatch", it.key());
+    }
+    signal_subscriptions.clear();
+    declared_signal_subscriptions.clear();
+    registry_mutex.unlock();
+    for (const QString &path : object_paths)
+        unregisterObject(path, QDBusConnection::UnregisterNode);
+    for (const QString &service : services)
+        unregisterService(service);
+}
+
+QDBusPendingCall RemoteDBusConnection::unregisterServiceAsync(const QString &serviceName)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(dbus_daemon_service, dbus_daemon_path,
+                                                          dbus_daemon_interface, "ReleaseName");
+    message << serviceName;
+    registry_mutex.lock();
+    registered_services.removeAll(serviceName);
+    registry_mutex.unlock();
+    return asyncCall(message);
+}
+
+void RemoteDBusConnection::processTunnelChannelOpened(bool success, const QString &dbus_address)
+{
+    if (!success) {
+        tunnel->statistics.connection_attempts_failed.fetchAndAddRelaxed(1);
+        finishOpening(false);
+        return;
+    }
+    RemoteDBusConnectionHandshake *handshake = new RemoteDBusConnectionHandshake(this, dbus_address);
+    Q_CHECK_PTR(handshake);
+    handshake_in_progress = true;
+    channel_closed_during_handshake = false;
+    handshake_pool()->start(handshake);
+}
+
+void RemoteDBusConnection::processHandshakeFinished()
+{
+    handshake_finished.acquire();
+    handshake_in_progress = false;
+    ref_mutex.lock();
+    ref.storeRelease(handshake_ref);
+    ref_mutex.unlock();
+    handshake_ref = nullptr;
+    if (ref.load()->isConnected()) {
+        tunnel->statistics.connections_opened.fetchAndAddRelaxed(1);
+        applyWrappedOperationTimeoutPolicy();
+        replaySignalSubscriptions();
+        if (heartbeat_interval_ms > 0)
+            heartbeat_timer.start(heartbeat_interval_ms);
+        if (lazy_connection_enabled && (lazy_idle_timeout_ms > 0)) {
+            idle_relayed_bytes = tunnel->statistics.bytes_remote_to_local.load() +
+                                 tunnel->statistics.bytes_local_to_remote.load();
+            idle_clock.start();
+            idle_check_active.storeRelease(1);
+            idle_timer.start(qMax(lazy_idle_timeout_ms / idle_check_resolution, 1));
+        }
+        finishOpening(true);
     } else {
-        Q_EMIT connectionOpened(false);
+        tunnel->statistics.connection_attempts_failed.fetchAndAddRelaxed(1);
+        QDBusError dbus_error = ref.load()->lastError();
+        QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
+        dropNativeDBusConnection();
+        Q_EMIT connectionError("D-Bus connection failed with " + formatDBusErrorDetails(&dbus_error));
+        finishOpening(false);
+    }
+    // Keep signals order as if handshake was synchronous: opening result first, closing next
+    if (channel_closed_during_handshake) {
+        channel_closed_during_handshake = false;
+        processTunnelChannelClosed(true);
     }
 }
 
@@ -586,37 +3062,320 @@ void RemoteDBusConnection::processTunnelChannelClosed(bool success)
 {
     if (!success)
         return;
+    if (handshake_in_progress) {
+        channel_closed_during_handshake = true;
+        return;
+    }
     dropNativeDBusConnection();
     Q_EMIT connectionClosed();
+    if (idle_close_pending) {
+        idle_close_pending = false;
+        // Operation requested reopening while closing (see startLazyOpen())
+        QMutexLocker locker(&lazy_open_mutex);
+        if (lazy_open_in_progress)
+            QtExtra::invokeQueued(tunnel, &RemoteDBusConnectionTunnel::openChannel,
+                                  reconnect_hostname, reconnect_port, reconnect_protocol);
+        return;
+    }
+    if (auto_reconnect_enabled && !close_requested)
+        scheduleReconnect();
 }
 
-bool RemoteDBusConnection::executeWrappedOperation(std::function<bool ()> operation)
+void RemoteDBusConnection::finishOpening(bool success)
 {
-    if (!(isConnectionOpened() && ref->isConnected()))
+    bool lazy_opened = completeLazyOpen();
+    if (reconnect_attempt == 0) {
+        // Reopened after idle shutdown, so it's restored same way as after automatic reconnection
+        if (success && lazy_opened)
+            replayRegistrations();
+        Q_EMIT connectionOpened(success);
+        return;
+    }
+    // Automatic reconnection attempt
+    if (close_requested || !auto_reconnect_enabled) {
+        reconnect_attempt = 0;
+        if (success) {
+            QTMETAMETHOD_INVOKE_QUEUED(tunnel, abortChannel);
+            dropNativeDBusConnection();
+        }
+        return;
+    }
+    if (!success) {
+        scheduleReconnect();
+        return;
+    }
+    reconnect_attempt = 0;
+    replayRegistrations();
+    Q_EMIT connectionOpened(true);
+}
+
+void RemoteDBusConnection::scheduleReconnect()
+{
+    // Exponential backoff with random jitter
+    qint64 delay_ms = reconnect_initial_delay_ms;
+    for (int i = 0; (i < reconnect_attempt) && (delay_ms < reconnect_max_delay_ms); i++)
+        delay_ms *= 2;
+    delay_ms = qMin(delay_ms, qint64(reconnect_max_delay_ms));
+    static thread_local std::mt19937 random_generator(std::random_device{}());
+    std::uniform_int_distribution<int> jitter_distribution(-reconnect_jitter_percent, reconnect_jitter_percent);
+    delay_ms += delay_ms * jitter_distribution(random_generator) / 100;
+    reconnect_attempt++;
+    Q_EMIT reconnectScheduled(reconnect_attempt, int(delay_ms));
+    reconnect_timer.start(int(delay_ms));
+}
+
+void RemoteDBusConnection::processReconnectTimeout()
+{
+    if (isConnectionOpened())
+        return;
+    QtExtra::invokeQueued(tunnel, &RemoteDBusConnectionTunnel::openChannel, reconnect_hostname, reconnect_port, reconnect_protocol);
+}
+
+// Waits for opening up to timeout_ms (negative value - without limit), returns true if connection is opened
+bool RemoteDBusConnection::openLazyConnection(int timeout_ms)
+{
+    QMutexLocker locker(&lazy_open_mutex);
+    if (!lazy_open_armed)
+        return false;
+    if (QThread::currentThread() == thread()) {
+        // Opening completes through events of this thread, so it can't be waited for here
+        locker.unlock();
+        startLazyOpen();
+        return false;
+    }
+    quint64 generation = lazy_open_generation;
+    QTMETAMETHOD_INVOKE_QUEUED(this, startLazyOpen);
+    QElapsedTimer wait_clock;
+    wait_clock.start();
+    while (lazy_open_armed && (lazy_open_generation == generation)) {
+        if (timeout_ms < 0) {
+            lazy_open_finished.wait(&lazy_open_mutex);
+            continue;
+        }
+        qint64 remaining_ms = timeout_ms - wait_clock.elapsed();
+        if (remaining_ms <= 0)
+            break;
+        lazy_open_finished.wait(&lazy_open_mutex, ulong(remaining_ms));
+    }
+    locker.unlock();
+    return isConnectionOpened();
+}
+
+void RemoteDBusConnection::startLazyOpen()
+{
+    QMutexLocker locker(&lazy_open_mutex);
+    if (lazy_open_in_progress)
+        return;
+    if (!lazy_open_armed || isConnectionOpened()) {
+        // Opened or closed meanwhile, nothing to wait for
+        lazy_open_generation++;
+        lazy_open_finished.wakeAll();
+        return;
+    }
+    lazy_open_in_progress = true;
+    locker.unlock();
+    close_requested = false;
+    if (idle_close_pending)
+        return; // opened when closing finishes (see processTunnelChannelClosed())
+    if ((reconnect_attempt > 0) && !reconnect_timer.isActive())
+        return; // automatic reconnection attempt is already running, its result is awaited
+    reconnect_timer.stop();
+    QtExtra::invokeQueued(tunnel, &RemoteDBusConnectionTunnel::openChannel,
+                          reconnect_hostname, reconnect_port, reconnect_protocol);
+}
+
+// Returns true if opening was requested by wrapped operation
+bool RemoteDBusConnection::completeLazyOpen()
+{
+    QMutexLocker locker(&lazy_open_mutex);
+    if (!lazy_open_in_progress)
+        return false;
+    lazy_open_in_progress = false;
+    lazy_open_generation++;
+    lazy_open_finished.wakeAll();
+    return true;
+}
+
+// Traffic is measured by relayed bytes counters, so any data passed in either direction counts as activity
+void RemoteDBusConnection::processIdleCheckTimeout()
+{
+    if (!isConnectionOpened())
+        return;
+    quint64 relayed_bytes = tunnel->statistics.bytes_remote_to_local.load() +
+                            tunnel->statistics.bytes_local_to_remote.load();
+    if (relayed_bytes != idle_relayed_bytes) {
+        idle_relayed_bytes = relayed_bytes;
+        idle_clock.start();
+        return;
+    }
+    if (idle_clock.elapsed() < lazy_idle_timeout_ms)
+        return;
+    if (tunnel->isWrappedOperationInProgress() || tunnel->hasOutstandingAsyncCalls()) {
+        // Operation awaiting reply isn't idle, even if nothing is relayed meanwhile
+        idle_clock.start();
+        return;
+    }
+    // Closed without automatic reconnection, next wrapped operation reopens it
+    tunnel->statistics.connections_closed_idle.fetchAndAddRelaxed(1);
+    close_requested = true;
+    idle_close_pending = true;
+    QTMETAMETHOD_INVOKE_QUEUED(tunnel, dropChannel);
+    dropNativeDBusConnection();
+}
+
+void RemoteDBusConnection::replayRegistrations()
+{
+    registry_mutex.lock();
+    QStringList services = registered_services;
+    QMap<QString, RegisteredObject> objects = registered_objects;
+    registry_mutex.unlock();
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it) {
+        const RegisteredObject &registered = it.value();
+        if (registered.object.isNull())
+            continue;
+        QString path = it.key();
+        executeWrappedOperation([path, registered](QDBusConnection &connection) {
+            if (registered.object.isNull())
+                return false;
+            if (registered.virtual_object)
+                return connection.registerVirtualObject(path, static_cast<QDBusVirtualObject *>(registered.object.data()),
+                                                  QDBusConnection::VirtualObjectRegisterOption(registered.options));
+            if (registered.interface.isEmpty())
+                return connection.registerObject(path, registered.object.data(),
+                                           QDBusConnection::RegisterOptions(registered.options));
+            return connection.registerObject(path, registered.interface, registered.object.data(),
+                                       QDBusConnection::RegisterOptions(registered.options));
+        });
+    }
+    // Names are requested all at once, so replay takes single round trip regardless of services count
+    for (const QString &service : services) {
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(registerServiceAsync(service), this);
+        Q_CHECK_PTR(watcher);
+        QObject::connect(watcher, &QDBusPendingCallWatcher::finished,
+                         this, [this, service](QDBusPendingCallWatcher *finished_watcher) {
+            finished_watcher->deleteLater();
+            QDBusMessage reply = finished_watcher->reply();
+            if (reply.type() != QDBusMessage::ReplyMessage) {
+                QDBusError dbus_error(reply);
+                Q_EMIT connectionError(QString("Service %1 registration restore failed with ").arg(service) +
+                                       formatDBusErrorDetails(&dbus_error));
+                return;
+            }
+            uint result = reply.arguments().isEmpty() ? 0 : reply.arguments().first().toUInt();
+            if ((result != dbus_request_name_reply_primary_owner) && (result != dbus_request_name_reply_already_owner))
+                Q_EMIT connectionError(QString("Service %1 registration restore failed, name is owned by other peer")
+                                       .arg(service));
+        });
+    }
+}
+
+// Abandonable operation may be executed out of calling thread and outlive caller, so it must own data it uses.
+// If completed is passed, it's set to false when operation was abandoned (so its results must not be read).
+bool RemoteDBusConnection::executeWrappedOperation(std::function<bool (QDBusConnection &)> operation, bool *completed,
+                                                   bool abandonable)
+{
+    if (completed != nullptr)
+        *completed = false;
+    int timeout_ms = tunnel->wrapped_operation_timeout_ms.load();
+    if (!isConnectionOpened()) {
+        // Opening on demand counts against operation deadline
+        QElapsedTimer open_clock;
+        open_clock.start();
+        openLazyConnection(timeout_ms);
+        if (timeout_ms != -1)
+            timeout_ms = qMax(timeout_ms - int(open_clock.elapsed()), 1);
+    }
+    int slot = tunnel->startWrappedOperation(timeout_ms);
+    if (slot == -1) {
+        tunnel->statistics.wrapped_operations_failed.fetchAndAddRelaxed(1);
+        tunnel->statistics.wrapped_operations_timed_out.fetchAndAddRelaxed(1);
+        QTMETAMETHOD_INVOKE_QUEUED_ARGS1(this, connectionError,
+                                         (const QString&, QString("D-Bus operation timed out waiting for free slot")));
+        return false;
+    }
+    // Own handle stays usable even if connection is dropped meanwhile (see dropNativeDBusConnection())
+    QDBusConnection connection = nativeDBusConnection();
+    if (!connection.isConnected()) {
+        tunnel->stopWrappedOperation(slot);
         return false;
-    QTMETAMETHOD_INVOKE(tunnel, syncStartWrappedOperation, Qt::BlockingQueuedConnection);
-    bool success = operation();
+    }
+    qint64 start_ns = tunnel->wrapped_operation_clock.nsecsElapsed();
+    bool success;
+    QDBusError dbus_error;
+    bool abandoned = false;
+    if (abandonable && (timeout_ms != -1) &&
+            (tunnel->wrapped_operation_timeout_policy.load() == AbandonOperationOnTimeout)) {
+        // Caller is released at deadline even if operation still blocks, its late result is discarded
+        std::shared_ptr<RemoteDBusConnectionAbandonableOperation::State> state =
+                std::make_shared<RemoteDBusConnectionAbandonableOperation::State>();
+        RemoteDBusConnectionAbandonableOperation *runnable =
+                new RemoteDBusConnectionAbandonableOperation(state, connection, operation);
+        Q_CHECK_PTR(runnable);
+        abandonable_operation_pool()->start(runnable);
+        abandoned = !state->finished.tryAcquire(1, timeout_ms);
+        success = !abandoned && state->success;
+        if (!success && !abandoned)
+            dbus_error = state->error;
+    } else {
+        success = operation(connection);
+        if (!success)
+            dbus_error = connection.lastError();
+    }
+    if (completed != nullptr)
+        *completed = !abandoned;
+    bool timed_out = !tunnel->stopWrappedOperation(slot) || abandoned;
+    StatisticsCounters &counters = tunnel->statistics;
+    counters.wrapped_operation_latency.record((tunnel->wrapped_operation_clock.nsecsElapsed() - start_ns) / 1000);
+    counters.wrapped_operations.fetchAndAddRelaxed(1);
     if (!success) {
+        counters.wrapped_operations_failed.fetchAndAddRelaxed(1);
+        if (timed_out)
+            counters.wrapped_operations_timed_out.fetchAndAddRelaxed(1);
         QString error_message;
-        if (!tunnel->isWrappedOperationTimedOut()) {
-            QDBusError dbus_error = ref->lastError();
+        if (!timed_out) {
             error_message = "D-Bus operation failed with " + formatDBusErrorDetails(&dbus_error);
         } else {
             error_message = "D-Bus operation timed out";
         }
         QTMETAMETHOD_INVOKE_QUEUED_ARGS1(this, connectionError, (const QString&, error_message));
     }
-    tunnel->asyncStopWrappedOperation();
     return success;
 }
 
 void RemoteDBusConnection::dropNativeDBusConnection()
 {
-    if (ref == nullptr)
+    if (!isConnectionOpened())
         return;
-    ref->disconnectFromBus(ref_name);
-    delete ref;
-    ref = nullptr;
+    heartbeat_timer.stop();
+    idle_timer.stop();
+    idle_check_active.storeRelease(0);
+    delete heartbeat_watcher;
+    heartbeat_watcher = nullptr;
+    registry_mutex.lock();
+    signal_subscriptions_active = false;
+    registry_mutex.unlock();
+    ref_mutex.lock();
+    QDBusConnection *old_ref = ref.fetchAndStoreOrdered(nullptr);
+    ref_mutex.unlock();
+    // Operations already passed connection check hold own handles (QDBusConnection is shared),
+    // so native connection is released by last of them, and they fail on their own once channel is closed
+    old_ref->disconnectFromBus(ref_name);
+    delete old_ref;
+    clearReplyCache();
+    // Match rules are gone with connection
+    QMutexLocker locker(&reply_cache_mutex);
+    reply_cache_services.clear();
+    reply_cache_objects.clear();
+}
+
+// May be called from any thread
+QDBusConnection RemoteDBusConnection::nativeDBusConnection() const
+{
+    QMutexLocker locker(&ref_mutex);
+    QDBusConnection *native_ref = ref.load();
+    if (native_ref == nullptr)
+        return QDBusConnection(QString()); // disconnected one
+    return *native_ref;
 }
 
 QString RemoteDBusConnection::formatDBusErrorDetails(const QDBusError *error)
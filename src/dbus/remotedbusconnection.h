@@ -9,10 +9,28 @@
 #define QTEXTRA_REMOTEDBUSCONNECTION_H
 
 #include <functional>
+#include <qatomic.h>
 #include <qobject.h>
 #include <qabstractsocket.h>
 #include <qdbusconnection.h>
+#include <qdbusmessage.h>
+#include <qdbuspendingcall.h>
+#include <qelapsedtimer.h>
+#include <qhash.h>
+#include <qmap.h>
+#include <qmutex.h>
+#include <qpointer.h>
+#include <qsemaphore.h>
+#include <qset.h>
+#ifndef QT_NO_SSL
+#include <qsslconfiguration.h>
+#endif
+#include <qstringlist.h>
 #include <qthread.h>
+#include <qtimer.h>
+#include <qvariant.h>
+#include <qvector.h>
+#include <qwaitcondition.h>
 
 namespace QtExtra {
 
@@ -40,11 +58,15 @@ namespace QtExtra {
   Class objects require an event loop (i.e. there are no waitFor<...> semantic for using them within any thread context
   in blocking manner).
 
-  Each time connection opened it starts listening on free localhost port, establishes connection with remote port,
-  creates QDBusConnection instance connected to localhost port and transfers data between connection endpoints.
+  Each time connection opened it starts listening on free localhost port (or Unix domain socket, see setLocalTransport()),
+  establishes connection with remote port, creates QDBusConnection instance connected to localhost port
+  and transfers data between connection endpoints.
   On closing connection it does corresponding disconnect/deallocate/free things in reverse order.
   Since QDBusConnection connect/disconnect calls are blocking, class uses separate thread
   for all networking and timeout detections.
+  D-Bus handshake (QDBusConnection::connectToBus() call) is performed in worker thread pool,
+  so opening connection never blocks thread this object lives in, and
+  connectionOpened() signal is emitted once handshake completes.
   Internal QDBusConnection instance (reference) lives only for active connection time.
   It isn't intended to be used externally (although, there is one exception, see constructInterface() method).
   Instead class provides subset of QDBusConnection API: it has methods wrapping object's methods and
@@ -101,7 +123,7 @@ namespace QtExtra {
   Using network proxy for connection isn't supported, although wrapped QAbstractSocket socket already implements it.
   The problem is that if proxy authentication required, QAbstractSocket fires proxyAuthenticationRequired() signal,
   which requires synchronous slot connection, where slot must handle request and return response in passed argument.
-  It isn't possible to acheive SIMILAR behavior in this class, because its thread is blocked in QDBusConnection::connectToBus()
+  It isn't possible to acheive SIMILAR behavior in this class, because handshake thread is blocked in QDBusConnection::connectToBus()
   call at this moment, and forwarding QAbstractSocket::proxyAuthenticationRequired() signal from network thread
   using blocked queued connection ends in deadlock.
   Yes, author COULD add some limited support, for example:
@@ -112,12 +134,72 @@ namespace QtExtra {
 
 */
 class RemoteDBusConnectionTunnel;
+class RemoteDBusConnectionHandshake;
 
 class RemoteDBusConnection : public QObject
 {
     Q_OBJECT
 public:
 
+    //! Transport used between tunnel and internal QDBusConnection instance
+    enum LocalTransport {
+        LocalTcpTransport,       //!< TCP connection with localhost port (default)
+        LocalUnixSocketTransport //!< Unix domain socket (abstract namespace one on Linux with Qt 5.10+), available on Unix platforms only
+    };
+
+    //! Thread running tunnel, which relays data between remote connection and internal QDBusConnection instance
+    enum TunnelThreadPolicy {
+        DedicatedTunnelThread, //!< own thread per instance (default)
+        SharedTunnelThread     //!< one of threads shared by all such instances (their number equals to QThread::idealThreadCount())
+    };
+
+    //! Reaction on wrapped operation timeout
+    enum WrappedOperationTimeoutPolicy {
+        DropConnectionOnTimeout,  //!< connection is dropped, unblocking all operations in progress (default)
+        AbandonOperationOnTimeout //!< only timed out operation fails, connection stays opened
+    };
+
+    //! Summary of latency distribution, values in microseconds
+    /*!
+      Values are estimated from logarithmic histogram buckets, so they are accurate to ~25%.
+    */
+    struct LatencyPercentiles {
+        quint64 count;  //!< number of samples
+        qint64 p50_us;  //!< median
+        qint64 p90_us;  //!< 90th percentile
+        qint64 p99_us;  //!< 99th percentile
+        qint64 p999_us; //!< 99.9th percentile
+        qint64 max_us;  //!< maximum
+    };
+
+    //! Snapshot of performance counters
+    /*!
+      Counters accumulate since construction or last resetStatistics() call.
+      \sa statistics()
+    */
+    struct Statistics {
+        quint64 bytes_remote_to_local;         //!< bytes relayed from remote connection to internal one
+        quint64 bytes_local_to_remote;         //!< bytes relayed from internal connection to remote one
+        quint64 wrapped_operations;            //!< wrapped operations executed (including failed ones)
+        quint64 wrapped_operations_failed;     //!< wrapped operations failed (including timed out ones)
+        quint64 wrapped_operations_timed_out;  //!< wrapped operations timed out
+        quint64 wrapped_operation_slot_waits;  //!< wrapped operations waited for free place (too many simultaneous ones)
+        qint64 wrapped_operation_slot_wait_us; //!< total time spent waiting for free place
+        LatencyPercentiles wrapped_operation_latency; //!< wrapped operations execution time
+        quint64 connections_opened;            //!< connections successfully opened (including automatic reconnections)
+        quint64 connections_closed_idle;       //!< connections closed by idle timeout in lazy connection mode
+        quint64 connection_attempts_failed;    //!< failed connection attempts
+        quint64 wrapped_operation_teardowns;   //!< connections dropped because of wrapped operation timeout
+        qint64 last_connect_duration_us;       //!< remote tcp/ip connection establishment time of last connection
+        qint64 last_handshake_duration_us;     //!< D-Bus authentication and hello time of last connection
+        quint64 reply_cache_hits;              //!< asynchronous calls answered from reply cache
+        quint64 reply_cache_misses;            //!< cacheable asynchronous calls sent to remote side
+        quint64 async_call_window_waits;       //!< asynchronous calls waited for place in calls window
+        quint64 async_call_window_timeouts;    //!< asynchronous calls failed, because their timeout expired while waiting
+        quint64 heartbeat_failures;            //!< heartbeat pings failed (or not answered in time)
+        qint64 last_heartbeat_rtt_us;          //!< round trip time of last answered heartbeat ping
+    };
+
     //! Constructs an object instance.
     /*!
       \param name unique QDBusConnection name for this instance
@@ -126,6 +208,17 @@ public:
     */
     explicit RemoteDBusConnection(const QString &name, QObject *parent = nullptr);
 
+    //! Constructs an object instance with specified tunnel thread policy.
+    /*!
+      Shared tunnel threads are intended for applications keeping many connections at once,
+      so threads overhead scales with number of CPU cores rather than with number of connections.
+      Tunnels sharing same thread affect latency of each other, if traffic is heavy.
+      \param name unique QDBusConnection name for this instance
+      \param thread_policy tunnel thread policy
+      \sa RemoteDBusConnection(const QString &, QObject *)
+    */
+    RemoteDBusConnection(const QString &name, TunnelThreadPolicy thread_policy, QObject *parent = nullptr);
+
     //! Destructs an object instance.
     /*! Closes opened connection, if any (remote connection being aborted, no signals emitted).
       \sa ~RemoteDBusConnection() and isConnectionOpened()
@@ -144,11 +237,33 @@ public:
     /*!
       New value applies to next operations.
       If called wrapped operation timeouts, then connection is dropped (signal will be emitted in next event loop cycle),
+      unless other policy is set (see setWrappedOperationTimeoutPolicy()),
       and corresponding call returns error value (depends on method interface).
+      Timeout expiration is detected by periodic check in this class thread, so it may be taken in effect
+      up to quarter of its value later.
+      Same timeout bounds waiting for free place, when too many operations are already in progress,
+      operation fails without being executed then.
       \param timeout_ms value in milliseconds
     */
     void setWrappedOperationTimeout(int timeout_ms);
 
+    //! Sets reaction on wrapped operation timeout.
+    /*!
+      Dropping connection guarantees that no operation blocks longer than timeout, but one slow remote method
+      then fails all other operations in progress and forces reconnection.
+      Abandoning fails only timed out operation: caller gets error at deadline, while operation is left to finish
+      in background thread and its late result is discarded. To make it possible, operations are executed
+      in background thread while this policy is set (so each of them takes extra thread switch).
+      Calls to remote side made by wrapped operations (registerService(), etc.) are given same timeout by QtDBus,
+      so abandoned ones give up on their own.
+      Dead remote link isn't detected by operations then, so use keepalive (see setKeepaliveEnabled())
+      or heartbeat (see setHeartbeat()) instead.
+      Operations executed by proxies from constructInterface() have own QtDBus timeouts (see QDBusAbstractInterface::setTimeout()).
+      Changes are applied immediately. May be called from any thread.
+      \sa WrappedOperationTimeoutPolicy and setWrappedOperationTimeout()
+    */
+    void setWrappedOperationTimeoutPolicy(WrappedOperationTimeoutPolicy policy);
+
     //! Sets keepalive option for remote connection socket.
     /*!
       Option can be set at any time, but may be platform-specific effects.
@@ -164,6 +279,244 @@ public:
     */
     void setLowDelayOption(bool enabled);
 
+    //! Sets watermarks limiting amount of data buffered by tunnel.
+    /*!
+      When one connection side produces data faster than other side consumes it (slow remote daemon,
+      stalled network), data pending to be written to destination socket grows.
+      When it exceeds high watermark, tunnel stops reading from source socket (so transport flow control
+      throttles the producer) until pending data drains below low watermark.
+      Zero high watermark (default) disables limits.
+      Zero-copy relay (if enabled) isn't affected, since it's naturally bounded by its pipe capacity.
+      Changes will be applied at next connection.
+      \param high_watermark pending data size in bytes at which reading pauses
+      \param low_watermark pending data size in bytes at which reading resumes (shouldn't exceed high_watermark)
+    */
+    void setRelayBufferWatermarks(qint64 high_watermark, qint64 low_watermark);
+
+    //! Sets kernel buffer sizes (SO_SNDBUF and SO_RCVBUF) of tunnel sockets.
+    /*!
+      Applied to both remote and local connection sockets. On links with high bandwidth-delay product
+      default sizes cap throughput well below line rate, so they should be raised to about bandwidth * round trip time.
+      Kernel may adjust (Linux doubles) or limit passed values (see net.core.wmem_max and net.core.rmem_max).
+      Amount of data buffered by tunnel itself is limited only by setRelayBufferWatermarks().
+      Changes will be applied at next connection.
+      \param send_buffer_size send buffer size in bytes, value 0 (default) keeps system default
+      \param receive_buffer_size receive buffer size in bytes, value 0 (default) keeps system default
+      \sa QAbstractSocket::SendBufferSizeSocketOption and QAbstractSocket::ReceiveBufferSizeSocketOption
+    */
+    void setSocketBufferSizes(int send_buffer_size, int receive_buffer_size);
+
+    //! Sets maximum amount of data moved by tunnel relay at once.
+    /*!
+      Regular relay passes data through preallocated buffer of this size (one per direction),
+      so relaying doesn't allocate memory per transfer (except with compression).
+      Zero-copy relay moves up to this size per splice() call (pipe is enlarged accordingly, if system allows).
+      Changes will be applied at next connection.
+      \param size chunk size in bytes, value 0 (default) means 64 KiB
+    */
+    void setRelayChunkSize(int size);
+
+    //! Sets transport for local side of tunnel.
+    /*!
+      Unix domain socket transport avoids passing every message through loopback TCP stack twice
+      and doesn't allocate ephemeral port for every opened connection.
+      Changes will be applied at next connection.
+      \return true on success, false if transport isn't supported on this platform
+      \sa LocalTransport
+    */
+    bool setLocalTransport(LocalTransport transport);
+
+    //! Sets "happy eyeballs" (RFC 8305) connect mode.
+    /*!
+      If enabled, host name passed to openConnection() is resolved to all its IPv6 and IPv4 addresses,
+      then connection attempts to them are started one after another with 250 ms delay (alternating address families),
+      without waiting for previous ones to fail. First established connection is used, others are aborted.
+      Resolved addresses are cached for 5 minutes, address connected last time is tried first at next connection.
+      It helps on dual-stack networks where one of families is broken.
+      Applies only if protocol passed to openConnection() is QAbstractSocket::AnyIPProtocol
+      and host isn't specified with literal address.
+      Changes will be applied at next connection.
+      \param enabled true - race connection attempts, false - connect as QAbstractSocket::connectToHost() does (default)
+    */
+    void setHappyEyeballsEnabled(bool enabled);
+
+    //! Sets early D-Bus handshake mode.
+    /*!
+      If enabled, D-Bus connection (authentication and Hello call) starts right after local side of tunnel is ready,
+      while remote connection is still being established. Data written by it is held until remote side connects,
+      so handshake proceeds as soon as possible and connection becomes usable earlier.
+      Remote connection failure is then reported as failed D-Bus handshake (connectionOpened(false) still fires once).
+      Changes will be applied at next connection.
+      \param enabled true - overlap handshake with remote connect, false - start it after remote connect (default)
+      \sa setFastOpenEnabled()
+    */
+    void setEarlyHandshakeEnabled(bool enabled);
+
+    //! Sets compression of data transferred over remote connection.
+    /*!
+      Compressed stream is understood only by RemoteDBusRelay (with compression enabled) listening on remote side,
+      which forwards decompressed data to dbus daemon. Local QDBusConnection side stays unchanged.
+      Intended for low-bandwidth links, since D-Bus messages (introspection data, property dictionaries, etc.)
+      are usually well compressible. Compression is zlib based (see qCompress()).
+      Each chunk of data relayed at once is compressed independently (no compression context is kept
+      between chunks), so it's effective for large messages, while small ones are mostly sent as is.
+      Zero-copy relay can't be used together with compression.
+      Changes will be applied at next connection.
+      \param enabled true - compress data, false - transfer raw D-Bus stream (default)
+      \param level compression level (see qCompress())
+      \sa RemoteDBusRelay
+    */
+    void setRelayCompression(bool enabled, int level = -1);
+
+#ifndef QT_NO_SSL
+    //! Sets TLS for remote connection.
+    /*!
+      Remote connection is encrypted using passed configuration (peer verification, CA certificates, protocol, etc.),
+      so remote side must be TLS endpoint forwarding to dbus daemon (for example, RemoteDBusRelay with RemoteDBusRelay::setSslConfiguration()).
+      Session tickets issued by remote side are kept and reused at next connection to same host,
+      so reconnection avoids full handshake. TLS 1.3 early data (0-RTT) isn't supported by QSslSocket.
+      Zero-copy relay can't be used together with TLS.
+      Changes will be applied at next connection.
+      Available only if Qt built with SSL support.
+      \sa unsetSslConfiguration() and QSslSocket
+    */
+    void setSslConfiguration(const QSslConfiguration &configuration);
+
+    //! Unsets TLS for remote connection.
+    /*!
+      Changes will be applied at next connection.
+      \sa setSslConfiguration()
+    */
+    void unsetSslConfiguration();
+#endif
+
+    //! Sets automatic reconnection mode.
+    /*!
+      If enabled, connection lost for any reason other than closeConnection() call is reopened automatically
+      (to host previously passed to openConnection()), with delays between attempts as set by setAutoReconnectBackoff().
+      Objects and virtual objects successfully registered with wrapped methods are registered again
+      before connectionOpened(true) fires, while services are requested again asynchronously at same time
+      (all at once, failures are reported with connectionError()).
+      Interfaces built with constructInterface() must be constructed again by user.
+      Losing connection still fires connectionClosed(), failed attempts fire connectionError() only
+      and each attempt is announced with reconnectScheduled().
+      Calling closeConnection() (even while waiting for next attempt) stops reconnection.
+      Disabled by default.
+      \sa setAutoReconnectBackoff() and reconnectScheduled()
+    */
+    void setAutoReconnectEnabled(bool enabled);
+
+    //! Sets delays between automatic reconnection attempts.
+    /*!
+      First attempt starts after initial delay, every next delay doubles until it reaches maximum.
+      Each delay is randomly spread by jitter, so many clients don't reconnect to same remote daemon simultaneously.
+      Default values are 100 ms, 30000 ms and 50%.
+      \param initial_delay_ms delay before first attempt in milliseconds
+      \param max_delay_ms delay limit in milliseconds
+      \param jitter_percent maximum deviation from delay in percents (0..100)
+      \sa setAutoReconnectEnabled()
+    */
+    void setAutoReconnectBackoff(int initial_delay_ms, int max_delay_ms, int jitter_percent);
+
+    //! Sets lazy (on demand) connection mode.
+    /*!
+      If enabled, openConnection() only remembers host and returns, connection is actually opened
+      by first wrapped operation (send(), asyncCall(), constructInterface(), registerService(), etc.),
+      which blocks until opening finishes (up to its timeout, see setWrappedOperationTimeout()) and then proceeds
+      (or fails, if opening failed or timed out).
+      Opening completes through events of this object thread, so operation called from this thread doesn't wait:
+      it starts opening and fails as if connection isn't opened, connectionOpened() tells when it may be retried.
+      After idle timeout without any data relayed in either direction, connection is closed
+      (firing connectionClosed(), but without automatic reconnection), so occasionally used instances
+      don't hold remote connection, its socket, and remote daemon resources all the time.
+      Next wrapped operation reopens it same way, restoring registrations as automatic reconnection does.
+      Calling closeConnection() disables reopening until next openConnection().
+      Mode suits client side usage: registered services are unavailable while connection is closed,
+      and heartbeat (see setHeartbeat()) or signal subscriptions produce traffic keeping connection opened.
+      Connection isn't closed while wrapped operation or asynchronous call is awaiting reply.
+      Changes will be applied at next connection.
+      \param enabled true - open connection on demand, false - open it with openConnection() call (default)
+      \param idle_timeout_ms idle period in milliseconds, value 0 (default) disables idle shutdown
+      \sa openConnection() and setAutoReconnectEnabled()
+    */
+    void setLazyConnectionEnabled(bool enabled, int idle_timeout_ms = 0);
+
+    //! Sets heartbeat used to detect dead remote link.
+    /*!
+      While connection is opened, org.freedesktop.DBus.Peer.Ping call is sent to remote dbus daemon
+      every interval (next one only after previous one finished). If reply doesn't arrive within timeout,
+      connection is considered lost and closed (as if remote side closed it), so half-open connection
+      is detected in about one interval on every platform, unlike with keepalive.
+      Round trip time of each answered ping is signalled with heartbeatRoundTrip().
+      Changes are applied immediately.
+      \param interval_ms ping interval in milliseconds, value 0 (default) disables heartbeat
+      \param timeout_ms reply timeout in milliseconds, value 0 means interval value
+      \sa heartbeatRoundTrip(), setKeepaliveEnabled() and setWrappedOperationTimeoutPolicy()
+    */
+    void setHeartbeat(int interval_ms, int timeout_ms = 0);
+
+    //! Sets maximum number of asynchronous calls outstanding at once.
+    /*!
+      Calls made with asyncCall() (and other asynchronous methods) are pipelined: many of them may be in flight
+      at once, so throughput on high-latency link is limited by window size rather than by one call per round trip.
+      When window is full, asyncCall() waits until any outstanding call finishes (or its own timeout expires,
+      then it fails with QDBusError::NoReply error without being sent). This way fast producer can't flood
+      remote side and tunnel buffers with requests.
+      Value 0 (default) means unlimited window (asyncCall() never waits). Changes are applied to calls made afterwards.
+      May be called from any thread.
+      \param max_outstanding maximum number of calls waiting for reply
+      \sa asyncCall()
+    */
+    void setAsyncCallWindow(int max_outstanding);
+
+    //! Sets lifetime of cached replies to property reads and introspection.
+    /*!
+      If enabled, replies to org.freedesktop.DBus.Properties.Get/GetAll and
+      org.freedesktop.DBus.Introspectable.Introspect calls made with asyncCall() are kept locally,
+      and repeated equal calls are answered from cache (returned pending call is already finished)
+      without round trip to remote side.
+      Property entries are invalidated by PropertiesChanged signal of corresponding object,
+      all entries of service are invalidated when its owner changes (NameOwnerChanged signal).
+      These signals are subscribed with match rules scoped to object path and service at first cacheable call to them
+      (and kept until connection closes), replies are cached only if subscription succeeded before call was sent.
+      Cache is cleared when connection closes.
+      Proxies built with constructInterface() bypass cache, since their calls go directly to internal QDBusConnection.
+      Changes are applied immediately.
+      \param properties_ttl_ms lifetime of property entries in milliseconds, value 0 (default) disables their caching
+      \param introspection_ttl_ms lifetime of introspection entries in milliseconds, value 0 (default) disables their caching
+      \sa clearReplyCache() and asyncCall()
+    */
+    void setReplyCacheTtl(int properties_ttl_ms, int introspection_ttl_ms);
+
+    //! Drops all cached replies.
+    /*!
+      May be called from any thread.
+      \sa setReplyCacheTtl()
+    */
+    void clearReplyCache();
+
+    //! Returns snapshot of performance counters.
+    /*!
+      Counters are updated lock-free, so snapshot may be slightly inconsistent (not taken atomically as whole)
+      if connection is busy. May be called from any thread.
+      \sa Statistics, resetStatistics() and setStatisticsReportInterval()
+    */
+    Statistics statistics() const;
+
+    //! Resets all performance counters to zero.
+    /*!
+      May be called from any thread.
+      \sa statistics()
+    */
+    void resetStatistics();
+
+    //! Sets interval of statisticsReported() signal.
+    /*!
+      \param interval_ms value in milliseconds, value 0 (default) disables signal
+      \sa statisticsReported()
+    */
+    void setStatisticsReportInterval(int interval_ms);
+
 #ifdef Q_OS_LINUX
     //! Sets keepalive parameters for remote connection socket.
     /*!
@@ -184,6 +537,63 @@ public:
       \sa setKeepaliveParameters()
     */
     void unsetKeepaliveParameters();
+
+    //! Sets quick ack mode (TCP_QUICKACK) for remote connection socket.
+    /*!
+      If enabled, delayed acknowledgements are disabled again after every read from remote socket,
+      so sender's congestion window grows faster and request-reply exchanges don't wait for ack timer.
+      Changes are applied immediately.
+      Available only for Linux platform.
+      \param enabled true - keep quick ack mode, false - let kernel decide (default)
+    */
+    void setTcpQuickAckEnabled(bool enabled);
+
+    //! Sets cork option (TCP_CORK) use around batched writes.
+    /*!
+      If enabled (default), remote socket is corked while sendBatch() writes messages,
+      so they leave in as few full-sized segments as possible.
+      Changes are applied immediately.
+      Available only for Linux platform.
+      \sa sendBatch()
+    */
+    void setTcpCorkEnabled(bool enabled);
+
+    //! Sets congestion control algorithm (TCP_CONGESTION) for remote connection socket.
+    /*!
+      Algorithm must be available in kernel (see net.ipv4.tcp_available_congestion_control),
+      for example "bbr" suits lossy high-latency links better than default "cubic".
+      Failure is reported with connectionError().
+      Changes will be applied at next connection.
+      Available only for Linux platform.
+      \param algorithm algorithm name, empty string (default) keeps system default
+    */
+    void setCongestionControl(const QString &algorithm);
+
+    //! Sets TCP Fast Open (TCP_FASTOPEN_CONNECT) for remote connection.
+    /*!
+      If enabled and server supports it (see RemoteDBusRelay::setFastOpenEnabled()), first data of connection
+      (D-Bus authentication request) is sent within SYN segment, saving one round trip at every connection
+      after the first one to same server. Applies only if host passed to openConnection() is literal address,
+      otherwise (or if kernel doesn't support it, i.e. older than 4.11) regular connect is used.
+      Best combined with early handshake (see setEarlyHandshakeEnabled()).
+      Such connection is established only when first reply arrives, so until then connect timeout
+      (see setConnectionTimeout()) still applies, and connect duration in statistics includes that round trip.
+      Changes will be applied at next connection.
+      Available only for Linux platform.
+      \param enabled true - use fast open, false - regular connect (default)
+    */
+    void setFastOpenEnabled(bool enabled);
+
+    //! Sets zero-copy relay mode for tunnel data transfer.
+    /*!
+      If enabled, data is moved between remote and local connection sockets using splice() system call
+      through intermediate pipe, i.e. without copying it to user space.
+      Otherwise (default), data is read from one socket into buffer and then written to another.
+      Changes will be applied at next connection.
+      Available only for Linux platform.
+      \param enabled true - use splice() relay, false - use regular copying relay
+    */
+    void setZeroCopyRelayEnabled(bool enabled);
 #endif
 
     //! Check if connection is open
@@ -198,6 +608,7 @@ public:
     /*!
       Initiates establishment of connection with remote dbus daemon, using timeout previously set.
       Parameters matches those defined in QAbstractSocket::connectToHost().
+      In lazy connection mode, connection is only opened by first wrapped operation (see setLazyConnectionEnabled()).
       \return true - if started successfully (connectionOpened() signal follows)
               false - failed (already opened)
       \sa isConnectionOpened(), connectionOpened(), closeConnection() and setConnectionTimeout()
@@ -220,6 +631,8 @@ public:
      Protected internally with timeout, previously set.
      See equally named QDBusConnection methods.
      If any error occurs, method returns relevant false/null/etc.
+     Methods may be called from different threads simultaneously (up to 64 operations at once,
+     others wait for free place), each operation tracks own deadline.
      \sa setWrappedOperationTimeout()
     */
     QDBusError lastError() const;
@@ -240,7 +653,8 @@ public:
     //! Wrapper for constructing QDBusAbstractInterface derived object (proxy)
     /*!
       Protected internally with timeout, previously set.
-      Passed constructor functor is being called during this method call.
+      Passed constructor functor is being called during this method call (always in calling thread,
+      so it isn't abandoned at timeout, see AbandonOperationOnTimeout).
       Restrictions for functor implementation (violations results in undefined behavior):
       - it shouldn't use passed QDBusConnection reference for any other purpose
       except just for constructing proxy object.
@@ -252,6 +666,77 @@ public:
     */
     bool constructInterface(std::function<void (const QDBusConnection &)> constructor);
 
+    //! Sends several messages at once.
+    /*!
+      Works as send() called for each message, but whole batch is executed as single wrapped operation
+      (with single timeout and at most one connectionError() signal).
+      On Linux, outgoing data of batch is held on remote socket (TCP_CORK) until batch is sent,
+      to leave in as few segments as possible.
+      \return per-message results, in order of messages
+      \sa send() and setWrappedOperationTimeout()
+    */
+    QVector<bool> sendBatch(const QVector<QDBusMessage> &messages);
+
+    //! Undoes all registrations made through this instance.
+    /*!
+      Unregisters objects and services registered with wrapped methods (registerServiceAsync() included)
+      and removes all signal subscriptions, so connection may be handed over to another user
+      without leaving previous user state attached (see RemoteDBusConnectionPool::releaseConnection()).
+      Registrations are forgotten even if connection is closed (so they aren't restored at next connection).
+      Proxies built with constructInterface() aren't tracked, so they are left untouched.
+    */
+    void unregisterAll();
+
+//@{
+   //! Signal subscriptions (match rules) managed on remote dbus daemon
+   /*!
+     Remote daemon routes broadcast signals only to connections having matching rules,
+     so declaring minimal set of rules needed by application keeps unneeded signal traffic off the remote link.
+     Rules are reference-counted: equal rules (compared as strings, ignoring leading and trailing whitespace)
+     added by different users result in single AddMatch request, and RemoveMatch is sent when last reference is removed.
+     Rules added while connection is closed are sent when it opens, and all rules are sent again
+     after every (re)connection.
+     setSignalSubscriptions() declares whole set at once (holding one reference per rule),
+     replacing set declared previously, while addSignalSubscription()/removeSignalSubscription()
+     manage individual references.
+     Requests are sent without waiting for reply (so opening connection doesn't take round trip per rule),
+     methods return false if request couldn't be sent (reference is counted nevertheless, so it will be retried
+     at next connection), request failure reported by daemon is signalled with connectionError().
+     May be called from any thread.
+     Match rules added implicitly by QtDBus (for example, when connecting to proxy signals) aren't affected
+     and rules declared here aren't deduplicated against them (daemon keeps both), so signals already
+     subscribed by proxies keep flowing regardless of declared set.
+     \sa connectionError()
+    */
+    bool addSignalSubscription(const QString &rule);
+    bool removeSignalSubscription(const QString &rule);
+    bool setSignalSubscriptions(const QStringList &rules);
+    QStringList signalSubscriptions();
+//@}
+
+//@{
+   //! Asynchronous variants of wrapped QDBusConnection object interface
+   /*!
+     These methods never block calling thread (unless calls window is full, see setAsyncCallWindow()):
+     they neither synchronize with this class thread, nor wait for remote reply. Instead, they return pending call object, which may be watched
+     using QDBusPendingCallWatcher (or QDBusPendingReply, with reply type as documented for corresponding
+     org.freedesktop.DBus method).
+     Reply timeout equals to value set by setWrappedOperationTimeout() (QtDBus default one, if not set),
+     unless overridden explicitly. It's deadline of each call on its own (time spent waiting for calls window included),
+     since nothing blocks, it fails only its call and doesn't drop connection.
+     If connection isn't opened, returned pending call is already finished with QDBusError::Disconnected error.
+     In lazy mode (see setLazyConnectionEnabled()) call waits for opening on demand as part of its deadline,
+     unless it's called from this object thread (then it starts opening and fails immediately).
+     \note
+     Services registered with registerServiceAsync() remain unknown to internal QDBusConnection bookkeeping
+     (they are handled by remote dbus daemon as usual).
+     \sa setWrappedOperationTimeout()
+    */
+    QDBusPendingCall asyncCall(const QDBusMessage &message, int timeout = -1);
+    QDBusPendingCall registerServiceAsync(const QString &serviceName);
+    QDBusPendingCall unregisterServiceAsync(const QString &serviceName);
+//@}
+
 Q_SIGNALS:
 /*! \defgroup Signals */
 /**@{*/
@@ -290,24 +775,130 @@ Q_SIGNALS:
     */
     void connectionClosed();
 
+    //! Signals that next automatic reconnection attempt is scheduled
+    /*!
+      \param attempt number of attempt, starting from 1
+      \param delay_ms delay before attempt in milliseconds
+      \sa setAutoReconnectEnabled()
+    */
+    void reconnectScheduled(int attempt, int delay_ms);
+
+    //! Signals performance counters periodically
+    /*!
+      \sa setStatisticsReportInterval() and statistics()
+    */
+    void statisticsReported(const QtExtra::RemoteDBusConnection::Statistics &statistics);
+
+    //! Signals round trip time of answered heartbeat ping
+    /*!
+      \param rtt_us round trip time in microseconds
+      \sa setHeartbeat()
+    */
+    void heartbeatRoundTrip(qint64 rtt_us);
+
 /**@}*/
 
 //@{
 /*! Private definitions */
 private Q_SLOTS:
-    void processTunnelChannelOpened(bool success, quint16 local_port);
+    void processTunnelChannelOpened(bool success, const QString &dbus_address);
     void processTunnelChannelClosed(bool success);
-    bool executeWrappedOperation(std::function<bool ()> operation);
+    void processHandshakeFinished();
+    void finishOpening(bool success);
+    void scheduleReconnect();
+    void processReconnectTimeout();
+    void startLazyOpen();
+    void processIdleCheckTimeout();
+    void processStatisticsReportTimeout();
+    void replayRegistrations();
+    void sendHeartbeat();
+    void processHeartbeatReply(QDBusPendingCallWatcher *watcher);
+    bool subscribeReplyCacheInvalidation(QDBusConnection &connection, const QString &service, const QString &path);
+    void replaySignalSubscriptions();
+    void processPropertiesChanged(const QDBusMessage &message);
+    void processNameOwnerChanged(const QString &name, const QString &old_owner, const QString &new_owner);
+    bool executeWrappedOperation(std::function<bool (QDBusConnection &)> operation, bool *completed = nullptr,
+                                 bool abandonable = true);
+    void applyWrappedOperationTimeoutPolicy();
     void dropNativeDBusConnection();
+    QDBusConnection nativeDBusConnection() const;
     QString formatDBusErrorDetails(const QDBusError *error);
 private:
-    QDBusConnection *ref;
+    QAtomicPointer<QDBusConnection> ref; // written only by this object thread
+    mutable QMutex ref_mutex; // guards ref changes against copying connection handle in other threads
     QString ref_name;
     RemoteDBusConnectionTunnel *tunnel;
     QThread tunnel_thread;
+    QThread *tunnel_shared_thread;
+    struct RegisteredObject {
+        QString interface; // empty, if registered without it
+        QPointer<QObject> object;
+        int options;
+        bool virtual_object;
+    };
+    QMutex registry_mutex;
+    QStringList registered_services;
+    QMap<QString, RegisteredObject> registered_objects;
+    QAtomicInt async_call_window;
+    QMap<QString, int> signal_subscriptions; // rule -> references count
+    QStringList declared_signal_subscriptions;
+    bool signal_subscriptions_active; // rules are sent to daemon of current connection
+    bool addSignalSubscriptionReference(const QString &normalized_rule);
+    bool removeSignalSubscriptionReference(const QString &normalized_rule);
+    bool sendMatchRuleRequest(const char *method, const QString &rule);
+    bool auto_reconnect_enabled;
+    int reconnect_initial_delay_ms, reconnect_max_delay_ms, reconnect_jitter_percent;
+    QString reconnect_hostname;
+    quint16 reconnect_port;
+    QAbstractSocket::NetworkLayerProtocol reconnect_protocol;
+    bool close_requested;
+    int reconnect_attempt;
+    QTimer reconnect_timer;
+    QTimer statistics_report_timer;
+    QTimer heartbeat_timer;
+    int heartbeat_interval_ms, heartbeat_timeout_ms;
+    QDBusPendingCallWatcher *heartbeat_watcher;
+    QElapsedTimer heartbeat_clock;
+    bool lazy_connection_enabled;
+    int lazy_idle_timeout_ms;
+    QMutex lazy_open_mutex;
+    QWaitCondition lazy_open_finished;
+    bool lazy_open_armed; // openConnection() called in lazy mode and not closed since
+    bool lazy_open_in_progress;
+    quint64 lazy_open_generation; // incremented by every finished opening, so waiters tell it apart from next one
+    bool idle_close_pending;
+    quint64 idle_relayed_bytes;
+    QElapsedTimer idle_clock;
+    QTimer idle_timer;
+    QAtomicInt idle_check_active; // outstanding asynchronous calls are tracked while set
+    bool openLazyConnection(int timeout_ms);
+    bool completeLazyOpen();
+    struct CachedReply {
+        QString service;
+        QString path;
+        QString property_interface; // empty for introspection and GetAll of all interfaces
+        bool introspection;
+        QList<QVariant> arguments;
+        qint64 expiry_ms;
+    };
+    QMutex reply_cache_mutex;
+    QHash<QString, CachedReply> reply_cache;
+    quint64 reply_cache_generation; // incremented by every invalidation, so replies requested before it aren't stored
+    QAtomicInt reply_cache_properties_ttl_ms, reply_cache_introspection_ttl_ms;
+    QElapsedTimer reply_cache_clock;
+    QSet<QString> reply_cache_services, reply_cache_objects; // names and paths subscribed to invalidation signals
+    bool lookupCachedReply(const QString &key, const QDBusMessage &message, QDBusMessage *reply);
+    void storeCachedReply(const QString &key, const QDBusMessage &message, const QDBusMessage &reply, quint64 generation);
+    friend class RemoteDBusConnectionHandshake;
+    bool handshake_in_progress;
+    bool channel_closed_during_handshake;
+    QDBusConnection *handshake_ref; // result passed from handshake thread
+    QSemaphore handshake_finished;
 //@}
 };
 
 } // namespace QtExtra
 
+Q_DECLARE_METATYPE(QtExtra::RemoteDBusConnection::Statistics)
+
 #endif // QTEXTRA_REMOTEDBUSCONNECTION_H
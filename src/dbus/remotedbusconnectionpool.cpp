@@ -0,0 +1,190 @@
+/**
+ * @file    remotedbusconnectionpool.cpp
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Implementation of RemoteDBusConnectionPool class
+ */
+
+#include "remotedbusconnectionpool.h"
+
+namespace QtExtra {
+
+RemoteDBusConnectionPool::RemoteDBusConnectionPool(const QString &name_prefix, QObject *parent) :
+    QObject(parent),
+    name_prefix(name_prefix),
+    names_counter(0),
+    spare_connections_count(1),
+    thread_policy(RemoteDBusConnection::SharedTunnelThread),
+    retry_timer(this)
+{
+    retry_timer.setSingleShot(true);
+    retry_timer.setInterval(1000);
+    QObject::connect(&retry_timer, &QTimer::timeout,
+                     this, &RemoteDBusConnectionPool::replenishSpareConnections);
+}
+
+RemoteDBusConnectionPool::~RemoteDBusConnectionPool()
+{
+    // Connections are children, but they must not signal into partially destructed object
+    for (RemoteDBusConnection *connection : findChildren<RemoteDBusConnection *>(QString(), Qt::FindDirectChildrenOnly)) {
+        QObject::disconnect(connection, nullptr, this, nullptr);
+        delete connection;
+    }
+}
+
+void RemoteDBusConnectionPool::setSpareConnectionsCount(int count)
+{
+    spare_connections_count = qMax(count, 0);
+}
+
+void RemoteDBusConnectionPool::setConnectionConfigurator(std::function<void (RemoteDBusConnection *)> configurator)
+{
+    this->configurator = configurator;
+}
+
+void RemoteDBusConnectionPool::setTunnelThreadPolicy(RemoteDBusConnection::TunnelThreadPolicy thread_policy)
+{
+    this->thread_policy = thread_policy;
+}
+
+void RemoteDBusConnectionPool::setRetryDelay(int delay_ms)
+{
+    retry_timer.setInterval(delay_ms);
+}
+
+void RemoteDBusConnectionPool::addHost(const QString &hostname, quint16 port)
+{
+    HostKey key(hostname, port);
+    if (hosts.contains(key))
+        return;
+    hosts.insert(key, Host());
+    replenishHostSpareConnections(key);
+}
+
+void RemoteDBusConnectionPool::removeHost(const QString &hostname, quint16 port)
+{
+    HostKey key(hostname, port);
+    if (!hosts.contains(key))
+        return;
+    Host host = hosts.take(key);
+    for (RemoteDBusConnection *connection : host.opening + host.spares)
+        discardConnection(connection);
+}
+
+RemoteDBusConnection *RemoteDBusConnectionPool::acquireConnection(const QString &user, const QString &hostname, quint16 port)
+{
+    HostKey key(hostname, port);
+    RemoteDBusConnection *connection = acquired_connections.value(user, nullptr);
+    if (connection != nullptr)
+        return (connection_hosts.value(connection) == key) ? connection : nullptr;
+    auto host_it = hosts.find(key);
+    if ((host_it == hosts.end()) || host_it->spares.isEmpty())
+        return nullptr;
+    connection = host_it->spares.takeFirst();
+    acquired_connections.insert(user, connection);
+    replenishHostSpareConnections(key);
+    return connection;
+}
+
+RemoteDBusConnection *RemoteDBusConnectionPool::connection(const QString &user) const
+{
+    return acquired_connections.value(user, nullptr);
+}
+
+void RemoteDBusConnectionPool::releaseConnection(const QString &user)
+{
+    RemoteDBusConnection *connection = acquired_connections.take(user);
+    if (connection == nullptr)
+        return;
+    auto host_it = hosts.find(connection_hosts.value(connection));
+    if (connection->isConnectionOpened() && (host_it != hosts.end())
+            && (host_it->opening.size() + host_it->spares.size() < spare_connections_count)) {
+        // Next user must not inherit objects, services and subscriptions of previous one
+        connection->unregisterAll();
+        host_it->spares.append(connection);
+        return;
+    }
+    discardConnection(connection);
+}
+
+void RemoteDBusConnectionPool::processConnectionOpened(bool success)
+{
+    RemoteDBusConnection *connection = qobject_cast<RemoteDBusConnection *>(sender());
+    Q_ASSERT(connection != nullptr);
+    if (!connection_hosts.contains(connection))
+        return;
+    HostKey key = connection_hosts.value(connection);
+    auto host_it = hosts.find(key);
+    Q_ASSERT(host_it != hosts.end());
+    host_it->opening.removeOne(connection);
+    if (!success) {
+        discardConnection(connection);
+        retry_timer.start();
+        return;
+    }
+    host_it->spares.append(connection);
+    Q_EMIT spareConnectionReady(key.first, key.second);
+}
+
+void RemoteDBusConnectionPool::processConnectionClosed()
+{
+    RemoteDBusConnection *connection = qobject_cast<RemoteDBusConnection *>(sender());
+    Q_ASSERT(connection != nullptr);
+    if (!connection_hosts.contains(connection)) {
+        // Discarded one finished closing
+        connection->deleteLater();
+        return;
+    }
+    QString user = acquired_connections.key(connection);
+    if (!user.isNull()) {
+        Q_EMIT connectionLost(user);
+        return;
+    }
+    HostKey key = connection_hosts.value(connection);
+    auto host_it = hosts.find(key);
+    Q_ASSERT(host_it != hosts.end());
+    host_it->spares.removeOne(connection);
+    discardConnection(connection);
+    replenishHostSpareConnections(key);
+}
+
+void RemoteDBusConnectionPool::replenishSpareConnections()
+{
+    for (const HostKey &key : hosts.keys())
+        replenishHostSpareConnections(key);
+}
+
+void RemoteDBusConnectionPool::replenishHostSpareConnections(const HostKey &key)
+{
+    auto host_it = hosts.find(key);
+    Q_ASSERT(host_it != hosts.end());
+    while (host_it->opening.size() + host_it->spares.size() < spare_connections_count) {
+        RemoteDBusConnection *connection = new RemoteDBusConnection(
+                    QString("%1_%2").arg(name_prefix).arg(names_counter++), thread_policy, this);
+        Q_CHECK_PTR(connection);
+        QObject::connect(connection, &RemoteDBusConnection::connectionOpened,
+                         this, &RemoteDBusConnectionPool::processConnectionOpened);
+        QObject::connect(connection, &RemoteDBusConnection::connectionClosed,
+                         this, &RemoteDBusConnectionPool::processConnectionClosed);
+        if (configurator)
+            configurator(connection);
+        if (!connection->openConnection(key.first, key.second)) {
+            delete connection;
+            retry_timer.start();
+            return;
+        }
+        connection_hosts.insert(connection, key);
+        host_it->opening.append(connection);
+    }
+}
+
+// Connection must be already removed from host lists
+void RemoteDBusConnectionPool::discardConnection(RemoteDBusConnection *connection)
+{
+    connection_hosts.remove(connection);
+    // If closing started, connection deleted in processConnectionClosed()
+    if (!(connection->isConnectionOpened() && connection->closeConnection()))
+        connection->deleteLater();
+}
+
+} // namespace QtExtra
@@ -0,0 +1,167 @@
+/**
+ * @file    remotedbusconnectionpool.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Header and documentation of RemoteDBusConnectionPool class
+ */
+
+#ifndef QTEXTRA_REMOTEDBUSCONNECTIONPOOL_H
+#define QTEXTRA_REMOTEDBUSCONNECTIONPOOL_H
+
+#include <functional>
+#include <qhash.h>
+#include <qlist.h>
+#include <qmap.h>
+#include <qobject.h>
+#include <qpair.h>
+#include <qtimer.h>
+#include "remotedbusconnection.h"
+
+namespace QtExtra {
+
+//! Pool of pre-opened remote D-Bus connections
+/*!
+  Class keeps specified number of spare RemoteDBusConnection instances opened to each registered remote host,
+  so they may be handed out to users without waiting for tcp/ip connection and D-Bus authentication handshake.
+  Handed out connection is replaced by new spare one in background.
+
+  Since remote dbus daemon requires separate stream per D-Bus connection, several logical connections
+  can't share single tcp/ip connection. Instead, pool hides connection establishment latency.
+
+  Typical usage:
+  \code
+  RemoteDBusConnectionPool pool("mypool");
+  pool.setSpareConnectionsCount(2);
+  pool.setConnectionConfigurator([](RemoteDBusConnection *connection) {
+    connection->setConnectionTimeout(500);
+    connection->setWrappedOperationTimeout(100);
+  });
+  pool.addHost("remote.host", 12345);
+  ... // wait for spareConnectionReady() signal
+  RemoteDBusConnection *connection = pool.acquireConnection("myuser", "remote.host", 12345);
+  if (connection != nullptr) {
+    ... // use already opened connection
+    pool.releaseConnection("myuser");
+  }
+  \endcode
+
+  \note
+  Class isn't thread-safe, all methods must be called from thread it belongs to.
+  Connections are owned by pool, users must not delete them.
+*/
+class RemoteDBusConnectionPool : public QObject
+{
+    Q_OBJECT
+public:
+
+    //! Constructs an object instance.
+    /*!
+      \param name_prefix prefix of QDBusConnection names of pooled connections
+             (each connection gets unique name with this prefix)
+    */
+    explicit RemoteDBusConnectionPool(const QString &name_prefix, QObject *parent = nullptr);
+
+    //! Destructs an object instance.
+    /*! All pooled connections, including acquired ones, are destructed (and being aborted).
+    */
+    ~RemoteDBusConnectionPool();
+
+    //! Sets number of spare connections kept opened per remote host.
+    /*!
+      Default value is 1. Changes will be applied at next replenishment.
+    */
+    void setSpareConnectionsCount(int count);
+
+    //! Sets function called for each new connection before it being opened.
+    /*!
+      Used to set timeouts, socket options, transport, etc.
+    */
+    void setConnectionConfigurator(std::function<void (RemoteDBusConnection *)> configurator);
+
+    //! Sets tunnel thread policy for new connections.
+    /*!
+      Default value is RemoteDBusConnection::SharedTunnelThread.
+      \sa RemoteDBusConnection::TunnelThreadPolicy
+    */
+    void setTunnelThreadPolicy(RemoteDBusConnection::TunnelThreadPolicy thread_policy);
+
+    //! Sets delay before reopening spare connections after failed attempt.
+    /*!
+      Default value is 1000 ms.
+      \param delay_ms value in milliseconds
+    */
+    void setRetryDelay(int delay_ms);
+
+    //! Registers remote host and starts opening spare connections to it.
+    void addHost(const QString &hostname, quint16 port);
+
+    //! Unregisters remote host and closes its spare connections.
+    /*! Acquired connections remain untouched until released.
+    */
+    void removeHost(const QString &hostname, quint16 port);
+
+    //! Hands out opened connection.
+    /*!
+      Repeated calls with same user return same connection until it released.
+      \param user arbitrary key identifying connection user
+      \return opened connection or nullptr, if no spare one is ready yet (or host isn't registered)
+      \sa releaseConnection(), spareConnectionReady()
+    */
+    RemoteDBusConnection *acquireConnection(const QString &user, const QString &hostname, quint16 port);
+
+    //! Returns connection acquired by user, or nullptr.
+    RemoteDBusConnection *connection(const QString &user) const;
+
+    //! Returns connection back to pool.
+    /*!
+      Connection, which is still opened, becomes spare again (if there is lack of them), otherwise it's closed.
+      Registrations made by user are undone before connection becomes spare (see RemoteDBusConnection::unregisterAll()).
+      User must not use connection after this call.
+    */
+    void releaseConnection(const QString &user);
+
+Q_SIGNALS:
+/*! \defgroup Signals */
+/**@{*/
+
+    //! Signals that spare connection to remote host was opened and may be acquired
+    void spareConnectionReady(const QString &hostname, quint16 port);
+
+    //! Signals that connection acquired by user was closed by remote side or due to error
+    /*! Connection remains acquired until released.
+    */
+    void connectionLost(const QString &user);
+
+/**@}*/
+
+private Q_SLOTS:
+    void processConnectionOpened(bool success);
+    void processConnectionClosed();
+    void replenishSpareConnections();
+
+private:
+    typedef QPair<QString, quint16> HostKey;
+    struct Host {
+        QList<RemoteDBusConnection *> opening;
+        QList<RemoteDBusConnection *> spares;
+    };
+
+    void replenishHostSpareConnections(const HostKey &key);
+    void discardConnection(RemoteDBusConnection *connection);
+
+//@{
+    QString name_prefix;
+    int names_counter;
+    int spare_connections_count;
+    std::function<void (RemoteDBusConnection *)> configurator;
+    RemoteDBusConnection::TunnelThreadPolicy thread_policy;
+    QTimer retry_timer;
+    QMap<HostKey, Host> hosts;
+    QHash<RemoteDBusConnection *, HostKey> connection_hosts;
+    QHash<QString, RemoteDBusConnection *> acquired_connections;
+//@}
+};
+
+} // namespace QtExtra
+
+#endif // QTEXTRA_REMOTEDBUSCONNECTIONPOOL_H
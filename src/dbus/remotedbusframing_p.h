@@ -0,0 +1,102 @@
+/**
+ * @file    remotedbusframing_p.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Compression framing used between RemoteDBusConnection and RemoteDBusRelay (private, not part of API)
+ */
+
+#ifndef QTEXTRA_REMOTEDBUSFRAMING_P_H
+#define QTEXTRA_REMOTEDBUSFRAMING_P_H
+
+#include <qbytearray.h>
+#include <qendian.h>
+
+namespace QtExtra {
+
+/*
+ * Stream is sequence of frames:
+ *  - 4 bytes header, big endian: bit 31 - payload is compressed, bits 0..30 - payload size;
+ *  - payload: raw data or qCompress() output (i.e. zlib stream prefixed with uncompressed size).
+ * Data is compressed only if it's large enough and compression actually reduces it.
+ * Frames are compressed independently (there is no compression context shared between them),
+ * so only data of single frame (chunk read at once) is used to find repetitions.
+ * Uncompressed size is checked before decompressing, since it's supplied by peer.
+ */
+static const int relay_frame_header_size = 4;
+static const quint32 relay_frame_compressed_flag = 0x80000000u;
+static const int relay_frame_max_input_size = 256 * 1024;
+static const int relay_frame_max_size = 2 * relay_frame_max_input_size;
+static const int relay_frame_compression_threshold = 128;
+
+class RelayFrameEncoder
+{
+public:
+    explicit RelayFrameEncoder(int compression_level = -1) : compression_level(compression_level) {}
+
+    QByteArray encode(const QByteArray &data) const
+    {
+        QByteArray frames;
+        for (int offset = 0; offset < data.size(); offset += relay_frame_max_input_size) {
+            QByteArray chunk = data.mid(offset, relay_frame_max_input_size);
+            quint32 header = quint32(chunk.size());
+            if (chunk.size() >= relay_frame_compression_threshold) {
+                QByteArray compressed = qCompress(chunk, compression_level);
+                if (compressed.size() < chunk.size()) {
+                    chunk = compressed;
+                    header = quint32(chunk.size()) | relay_frame_compressed_flag;
+                }
+            }
+            char header_buf[relay_frame_header_size];
+            qToBigEndian(header, reinterpret_cast<uchar *>(header_buf));
+            frames.append(header_buf, relay_frame_header_size);
+            frames.append(chunk);
+        }
+        return frames;
+    }
+
+private:
+    int compression_level;
+};
+
+class RelayFrameDecoder
+{
+public:
+    //! Appends received stream data, returns false if stream is corrupted
+    bool decode(const QByteArray &data, QByteArray *output)
+    {
+        pending.append(data);
+        int offset = 0;
+        while (pending.size() - offset >= relay_frame_header_size) {
+            quint32 header = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(pending.constData() + offset));
+            int payload_size = int(header & ~relay_frame_compressed_flag);
+            if (payload_size > relay_frame_max_size)
+                return false;
+            if (pending.size() - offset - relay_frame_header_size < payload_size)
+                break;
+            QByteArray payload = pending.mid(offset + relay_frame_header_size, payload_size);
+            offset += relay_frame_header_size + payload_size;
+            if (header & relay_frame_compressed_flag) {
+                if (payload.size() < int(sizeof(quint32)))
+                    return false;
+                quint32 uncompressed_size = qFromBigEndian<quint32>(reinterpret_cast<const uchar *>(payload.constData()));
+                if ((uncompressed_size == 0) || (uncompressed_size > quint32(relay_frame_max_input_size)))
+                    return false;
+                payload = qUncompress(payload);
+                if (payload.size() != int(uncompressed_size))
+                    return false;
+            }
+            output->append(payload);
+        }
+        pending.remove(0, offset);
+        return true;
+    }
+
+    void reset() {pending.clear();}
+
+private:
+    QByteArray pending;
+};
+
+} // namespace QtExtra
+
+#endif // QTEXTRA_REMOTEDBUSFRAMING_P_H
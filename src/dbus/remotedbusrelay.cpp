@@ -0,0 +1,368 @@
+/**
+ * @file    remotedbusrelay.cpp
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Implementation of RemoteDBusRelay class
+ */
+
+#include <qglobal.h>
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+#include <qlocalsocket.h>
+#include <qtcpserver.h>
+#include <qtcpsocket.h>
+#ifndef QT_NO_SSL
+#include <qsslsocket.h>
+#endif
+#include "remotedbusrelay.h"
+#include "remotedbusframing_p.h"
+
+namespace QtExtra {
+
+// Server starting TLS on accepted connections, if enabled
+class RemoteDBusRelayServer : public QTcpServer
+{
+public:
+    explicit RemoteDBusRelayServer(QObject *parent);
+
+#ifndef QT_NO_SSL
+    bool ssl_enabled;
+    QSslConfiguration ssl_configuration;
+#endif
+
+protected:
+    void incomingConnection(qintptr socket_descriptor) override;
+};
+
+RemoteDBusRelayServer::RemoteDBusRelayServer(QObject *parent) :
+    QTcpServer(parent)
+#ifndef QT_NO_SSL
+    , ssl_enabled(false)
+#endif
+{
+}
+
+void RemoteDBusRelayServer::incomingConnection(qintptr socket_descriptor)
+{
+#ifndef QT_NO_SSL
+    if (ssl_enabled) {
+        QSslSocket *socket = new QSslSocket(this);
+        Q_CHECK_PTR(socket);
+        if (!socket->setSocketDescriptor(socket_descriptor)) {
+            delete socket;
+            return;
+        }
+        socket->setSslConfiguration(ssl_configuration);
+        // Data written before handshake completes is buffered and sent encrypted afterwards
+        socket->startServerEncryption();
+        addPendingConnection(socket);
+        return;
+    }
+#endif
+    QTcpServer::incomingConnection(socket_descriptor);
+}
+
+// Single relayed connection, deletes itself when both sides closed
+class RemoteDBusRelaySession : public QObject
+{
+    Q_OBJECT
+public:
+    RemoteDBusRelaySession(QTcpSocket *client_socket, bool compression_active, int compression_level,
+                           QObject *parent);
+    void connectToDaemon(const QString &hostname, quint16 port);
+    void connectToDaemon(const QString &socket_path);
+
+public Q_SLOTS:
+    void processDaemonConnected();
+    void processClientReadyRead();
+    void processDaemonReadyRead();
+    void processClientError();
+#ifndef QT_NO_SSL
+    void processClientSslErrors(const QList<QSslError> &errors);
+#endif
+    void processDaemonError();
+    void processDisconnected();
+
+Q_SIGNALS:
+    void sessionError(const QString &message);
+
+public:
+    void setupDaemonSocket();
+    void closeSocket(QIODevice *socket);
+    bool isSocketClosed(QIODevice *socket) const;
+
+    QTcpSocket *client_socket;
+    QIODevice *daemon_socket;
+    bool daemon_connected;
+    bool compression_active;
+    RelayFrameEncoder frame_encoder;
+    RelayFrameDecoder frame_decoder;
+};
+
+RemoteDBusRelaySession::RemoteDBusRelaySession(QTcpSocket *client_socket, bool compression_active, int compression_level,
+                                               QObject *parent) :
+    QObject(parent),
+    client_socket(client_socket),
+    daemon_socket(nullptr),
+    daemon_connected(false),
+    compression_active(compression_active),
+    frame_encoder(compression_level)
+{
+    client_socket->setParent(this);
+    QObject::connect(client_socket, &QTcpSocket::readyRead,
+                     this, &RemoteDBusRelaySession::processClientReadyRead);
+    QObject::connect(client_socket, &QTcpSocket::disconnected,
+                     this, &RemoteDBusRelaySession::processDisconnected);
+    QObject::connect(client_socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
+                     this, &RemoteDBusRelaySession::processClientError);
+#ifndef QT_NO_SSL
+    if (QSslSocket *ssl_socket = qobject_cast<QSslSocket *>(client_socket))
+        QObject::connect(ssl_socket, QOverload<const QList<QSslError> &>::of(&QSslSocket::sslErrors),
+                         this, &RemoteDBusRelaySession::processClientSslErrors);
+#endif
+}
+
+void RemoteDBusRelaySession::connectToDaemon(const QString &hostname, quint16 port)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    Q_CHECK_PTR(socket);
+    daemon_socket = socket;
+    QObject::connect(socket, &QTcpSocket::connected,
+                     this, &RemoteDBusRelaySession::processDaemonConnected);
+    QObject::connect(socket, &QTcpSocket::disconnected,
+                     this, &RemoteDBusRelaySession::processDisconnected);
+    QObject::connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
+                     this, &RemoteDBusRelaySession::processDaemonError);
+    setupDaemonSocket();
+    socket->connectToHost(hostname, port);
+}
+
+void RemoteDBusRelaySession::connectToDaemon(const QString &socket_path)
+{
+    QLocalSocket *socket = new QLocalSocket(this);
+    Q_CHECK_PTR(socket);
+    daemon_socket = socket;
+    QObject::connect(socket, &QLocalSocket::connected,
+                     this, &RemoteDBusRelaySession::processDaemonConnected);
+    QObject::connect(socket, &QLocalSocket::disconnected,
+                     this, &RemoteDBusRelaySession::processDisconnected);
+    QObject::connect(socket, QOverload<QLocalSocket::LocalSocketError>::of(&QLocalSocket::error),
+                     this, &RemoteDBusRelaySession::processDaemonError);
+    setupDaemonSocket();
+    socket->connectToServer(socket_path);
+}
+
+void RemoteDBusRelaySession::setupDaemonSocket()
+{
+    QObject::connect(daemon_socket, &QIODevice::readyRead,
+                     this, &RemoteDBusRelaySession::processDaemonReadyRead);
+}
+
+void RemoteDBusRelaySession::processDaemonConnected()
+{
+    daemon_connected = true;
+    // Client may already sent authentication request
+    processClientReadyRead();
+}
+
+void RemoteDBusRelaySession::processClientReadyRead()
+{
+    // Data remains buffered in client socket until daemon connection established
+    if (!daemon_connected)
+        return;
+    QByteArray data = client_socket->readAll();
+    if (data.isEmpty())
+        return;
+    if (compression_active) {
+        QByteArray decoded;
+        if (!frame_decoder.decode(data, &decoded)) {
+            Q_EMIT sessionError("Corrupted compressed stream received from client, aborting");
+            client_socket->abort();
+            return;
+        }
+        data = decoded;
+        if (data.isEmpty())
+            return;
+    }
+    daemon_socket->write(data);
+}
+
+void RemoteDBusRelaySession::processDaemonReadyRead()
+{
+    QByteArray data = daemon_socket->readAll();
+    if (data.isEmpty())
+        return;
+    if (compression_active)
+        data = frame_encoder.encode(data);
+    client_socket->write(data);
+}
+
+void RemoteDBusRelaySession::processClientError()
+{
+    if (client_socket->error() != QAbstractSocket::RemoteHostClosedError)
+        Q_EMIT sessionError("Client connection error: " + client_socket->errorString());
+    processDisconnected();
+}
+
+#ifndef QT_NO_SSL
+void RemoteDBusRelaySession::processClientSslErrors(const QList<QSslError> &errors)
+{
+    // Unless ignored by configuration, handshake fails with error signalled afterwards
+    for (const QSslError &error : errors)
+        Q_EMIT sessionError("Client connection SSL error: " + error.errorString());
+}
+#endif
+
+void RemoteDBusRelaySession::processDaemonError()
+{
+    Q_EMIT sessionError("D-Bus daemon connection error: " + daemon_socket->errorString());
+    processDisconnected();
+}
+
+// Any side closed, close another one gracefully (so pending data is delivered)
+void RemoteDBusRelaySession::processDisconnected()
+{
+    closeSocket(client_socket);
+    if (daemon_socket != nullptr)
+        closeSocket(daemon_socket);
+    if (isSocketClosed(client_socket) && ((daemon_socket == nullptr) || isSocketClosed(daemon_socket)))
+        deleteLater();
+}
+
+void RemoteDBusRelaySession::closeSocket(QIODevice *socket)
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket)) {
+        if (abstract_socket->state() == QAbstractSocket::ConnectedState)
+            abstract_socket->disconnectFromHost();
+        else if (abstract_socket->state() != QAbstractSocket::ClosingState)
+            abstract_socket->abort();
+    } else if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket)) {
+        if (local_socket->state() == QLocalSocket::ConnectedState)
+            local_socket->disconnectFromServer();
+        else if (local_socket->state() != QLocalSocket::ClosingState)
+            local_socket->abort();
+    }
+}
+
+bool RemoteDBusRelaySession::isSocketClosed(QIODevice *socket) const
+{
+    if (QAbstractSocket *abstract_socket = qobject_cast<QAbstractSocket *>(socket))
+        return (abstract_socket->state() == QAbstractSocket::UnconnectedState);
+    if (QLocalSocket *local_socket = qobject_cast<QLocalSocket *>(socket))
+        return (local_socket->state() == QLocalSocket::UnconnectedState);
+    return true;
+}
+
+RemoteDBusRelay::RemoteDBusRelay(QObject *parent) :
+    QObject(parent),
+    server(new RemoteDBusRelayServer(this)),
+    daemon_hostname("localhost"),
+    daemon_port(0),
+    compression_enabled(true),
+    compression_level(-1),
+    fast_open_enabled(false)
+{
+    Q_CHECK_PTR(server);
+    QObject::connect(server, &QTcpServer::newConnection,
+                     this, &RemoteDBusRelay::processNewConnection);
+}
+
+RemoteDBusRelay::~RemoteDBusRelay()
+{
+    // Sessions are children and abort their connections on destruction
+    close();
+}
+
+void RemoteDBusRelay::setDBusDaemonAddress(const QString &hostname, quint16 port)
+{
+    daemon_hostname = hostname;
+    daemon_port = port;
+    daemon_socket_path.clear();
+}
+
+void RemoteDBusRelay::setDBusDaemonLocalSocket(const QString &path)
+{
+    daemon_socket_path = path;
+}
+
+void RemoteDBusRelay::setCompression(bool enabled, int level)
+{
+    compression_enabled = enabled;
+    compression_level = level;
+}
+
+#ifndef QT_NO_SSL
+void RemoteDBusRelay::setSslConfiguration(const QSslConfiguration &configuration)
+{
+    server->ssl_enabled = true;
+    server->ssl_configuration = configuration;
+}
+
+void RemoteDBusRelay::unsetSslConfiguration()
+{
+    server->ssl_enabled = false;
+    server->ssl_configuration = QSslConfiguration();
+}
+#endif
+
+#ifdef Q_OS_LINUX
+// Maximum number of pending fast open connections (not completed handshake yet)
+static const int fast_open_queue_length = 16;
+
+void RemoteDBusRelay::setFastOpenEnabled(bool enabled)
+{
+    fast_open_enabled = enabled;
+}
+#endif
+
+bool RemoteDBusRelay::listen(const QHostAddress &address, quint16 port)
+{
+    if (!server->listen(address, port))
+        return false;
+#ifdef Q_OS_LINUX
+    if (fast_open_enabled) {
+        int optval = fast_open_queue_length;
+        if (setsockopt(int(server->socketDescriptor()), SOL_TCP, TCP_FASTOPEN, &optval, sizeof(optval)) != 0) {
+            char error_buf[255];
+            Q_EMIT relayError(QString("Failed to enable fast open for listening socket with error: %1 (%2)")
+                              .arg(errno).arg(strerror_r(errno, error_buf, sizeof(error_buf))));
+        }
+    }
+#endif
+    return true;
+}
+
+void RemoteDBusRelay::close()
+{
+    server->close();
+}
+
+quint16 RemoteDBusRelay::serverPort() const
+{
+    return server->serverPort();
+}
+
+void RemoteDBusRelay::processNewConnection()
+{
+    while (QTcpSocket *client_socket = server->nextPendingConnection()) {
+        client_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        RemoteDBusRelaySession *session = new RemoteDBusRelaySession(client_socket, compression_enabled,
+                                                                     compression_level, this);
+        Q_CHECK_PTR(session);
+        QObject::connect(session, &RemoteDBusRelaySession::sessionError,
+                         this, &RemoteDBusRelay::relayError);
+        if (daemon_socket_path.isEmpty())
+            session->connectToDaemon(daemon_hostname, daemon_port);
+        else
+            session->connectToDaemon(daemon_socket_path);
+    }
+}
+
+} // namespace QtExtra
+
+#include "remotedbusrelay.moc"
@@ -0,0 +1,150 @@
+/**
+ * @file    remotedbusrelay.h
+ * @author  agent
+ * @date    14.10.2026
+ * @brief   Header and documentation of RemoteDBusRelay class
+ */
+
+#ifndef QTEXTRA_REMOTEDBUSRELAY_H
+#define QTEXTRA_REMOTEDBUSRELAY_H
+
+#include <qhostaddress.h>
+#include <qobject.h>
+#ifndef QT_NO_SSL
+#include <qsslconfiguration.h>
+#endif
+
+namespace QtExtra {
+
+class RemoteDBusRelayServer;
+
+//! Companion relay for RemoteDBusConnection running on remote host
+/*!
+  Class accepts tcp/ip connections from RemoteDBusConnection instances and forwards each of them
+  to dbus daemon (via separate connection to its tcp/ip port or Unix domain socket).
+  If compression enabled, it decodes stream compressed by RemoteDBusConnection::setRelayCompression()
+  and compresses data sent back, i.e. both sides must be configured equally.
+  Same applies to TLS (see setSslConfiguration() and RemoteDBusConnection::setSslConfiguration()).
+
+  Typical usage (on remote host):
+  \code
+  RemoteDBusRelay relay;
+  relay.setDBusDaemonLocalSocket("/var/run/dbus/system_bus_socket");
+  relay.setCompression(true);
+  relay.listen(QHostAddress::Any, 12345);
+  \endcode
+
+  \note
+  D-Bus authentication passes through relay unchanged. Since dbus daemon sees relay process as its peer,
+  authentication mechanisms relying on peer credentials (EXTERNAL over Unix domain socket)
+  succeed only if client user id matches relay process one. Otherwise daemon must allow other mechanisms.
+  Class requires an event loop.
+*/
+class RemoteDBusRelay : public QObject
+{
+    Q_OBJECT
+public:
+
+    //! Constructs an object instance.
+    explicit RemoteDBusRelay(QObject *parent = nullptr);
+
+    //! Destructs an object instance.
+    /*! Aborts all relayed connections.
+    */
+    ~RemoteDBusRelay();
+
+    //! Sets dbus daemon tcp/ip address to forward connections to.
+    /*!
+      Affects connections accepted after this call.
+    */
+    void setDBusDaemonAddress(const QString &hostname, quint16 port);
+
+    //! Sets dbus daemon Unix domain socket (pathname one) to forward connections to.
+    /*!
+      Affects connections accepted after this call.
+      \sa QLocalSocket::connectToServer()
+    */
+    void setDBusDaemonLocalSocket(const QString &path);
+
+    //! Sets compression of data transferred over accepted connections.
+    /*!
+      Affects connections accepted after this call.
+      \param enabled true - compressed stream (default), false - raw D-Bus stream (plain forwarding)
+      \param level compression level (see qCompress())
+      \sa RemoteDBusConnection::setRelayCompression()
+    */
+    void setCompression(bool enabled, int level = -1);
+
+#ifndef QT_NO_SSL
+    //! Sets TLS for accepted connections.
+    /*!
+      Relay acts as TLS server using passed configuration (local certificate, private key, protocol, etc.).
+      Connection to dbus daemon stays unencrypted.
+      Affects connections accepted after this call.
+      Available only if Qt built with SSL support.
+      \sa unsetSslConfiguration(), RemoteDBusConnection::setSslConfiguration() and QSslSocket::startServerEncryption()
+    */
+    void setSslConfiguration(const QSslConfiguration &configuration);
+
+    //! Unsets TLS for accepted connections.
+    /*!
+      Affects connections accepted after this call.
+      \sa setSslConfiguration()
+    */
+    void unsetSslConfiguration();
+#endif
+
+#ifdef Q_OS_LINUX
+    //! Sets TCP Fast Open (TCP_FASTOPEN) for listening socket.
+    /*!
+      Lets clients with fast open enabled send data within SYN segment (see RemoteDBusConnection::setFastOpenEnabled()).
+      Affects listening started after this call.
+      Available only for Linux platform.
+      \param enabled true - accept fast open connections, false - don't (default)
+    */
+    void setFastOpenEnabled(bool enabled);
+#endif
+
+    //! Starts listening for incoming connections.
+    /*!
+      \return true on success, false otherwise
+      \sa QTcpServer::listen()
+    */
+    bool listen(const QHostAddress &address = QHostAddress::Any, quint16 port = 0);
+
+    //! Stops listening (already relayed connections remain untouched).
+    void close();
+
+    //! Returns listening port.
+    quint16 serverPort() const;
+
+Q_SIGNALS:
+/*! \defgroup Signals */
+/**@{*/
+
+    //! Signals error encountered in any relayed connection
+    /*!
+      \param message text describing error source
+    */
+    void relayError(const QString &message);
+
+/**@}*/
+
+//@{
+/*! Private definitions */
+private Q_SLOTS:
+    void processNewConnection();
+private:
+    RemoteDBusRelayServer *server;
+    QString daemon_hostname;
+    quint16 daemon_port;
+    QString daemon_socket_path;
+    bool compression_enabled;
+    int compression_level;
+    bool fast_open_enabled;
+//@}
+};
+
+} // namespace QtExtra
+
+#endif // QTEXTRA_REMOTEDBUSRELAY_H